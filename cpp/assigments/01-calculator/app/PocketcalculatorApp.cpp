@@ -1,8 +1,181 @@
+#include "CalculatorServer.hpp"
+#include "Instrumentation.hpp"
+#include "MappedFile.hpp"
 #include "Pocketcalculator.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <csignal>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
 
-auto main() -> int
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace
+{
+    // SIGUSR1 is blocked in every thread and taken synchronously by this one,
+    // so the dump runs outside of signal context. Must run before any other thread starts.
+    auto dumpStatisticsOnSignal() -> void
+    {
+        sigset_t signals{};
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGUSR1);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        std::thread{[signals]
+                    {
+                        int signal{};
+                        while (sigwait(&signals, &signal) == 0)
+                        {
+                            printStatistics(collectStatistics(), std::cerr);
+                        }
+                    }}
+            .detach();
+    }
+
+    CalculatorServer *runningServer{};
+
+    auto stopServer(int) -> void
+    {
+        runningServer->stop();
+    }
+
+    // Routes SIGINT and SIGTERM to the server for as long as it exists,
+    // including when run() leaves by an exception.
+    struct StopOnSignal
+    {
+        explicit StopOnSignal(CalculatorServer &server)
+        {
+            runningServer = &server;
+            std::signal(SIGINT, stopServer);
+            std::signal(SIGTERM, stopServer);
+        }
+
+        ~StopOnSignal()
+        {
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+            runningServer = nullptr;
+        }
+
+        StopOnSignal(StopOnSignal const &) = delete;
+        auto operator=(StopOnSignal const &) -> StopOnSignal & = delete;
+    };
+
+    auto serve(std::string const &socketPath, PocketcalculatorOptions const &options) -> int
+    {
+        try
+        {
+            CalculatorServer server{socketPath, options};
+            StopOnSignal const stopOnSignal{server};
+            server.run();
+            return 0;
+        }
+        catch (std::exception const &error)
+        {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+    }
+
+    template <typename T>
+    auto parseNumber(std::string_view text, T &value) -> bool
+    {
+        auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc{} && end == text.data() + text.size();
+    }
+
+    auto usage(char const *program) -> int
+    {
+        std::cerr << "usage: " << program << " [-j|--threads N] [-w|--width N] [--wide] [--render-cache N] [--listen PATH] [--stats]\n"
+                  << "  -j, --threads N  evaluate on N threads (0 uses all cores)\n"
+                  << "  -w, --width N    show results wider than N characters as Error (default 8)\n"
+                  << "  --wide           overflow-checked 64-bit arithmetic\n"
+                  << "  --render-cache N cache the blocks of N recent results per thread (default 256, at most 16384, 0 disables)\n"
+                  << "  --listen PATH    serve sessions on a Unix domain socket instead of stdin\n"
+                  << "  --stats          print counters and latencies on exit (and on SIGUSR1)\n";
+        return 1;
+    }
+}
+
+auto main(int argc, char *argv[]) -> int
 {
-    pocketcalculator(std::cin, std::cout);
-}
\ No newline at end of file
+    if constexpr (statisticsEnabled)
+    {
+        dumpStatisticsOnSignal();
+    }
+
+    PocketcalculatorOptions options{};
+    std::string socketPath{};
+    bool stats{};
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view const arg{argv[i]};
+        bool const hasValue = i + 1 < argc;
+        if ((arg == "-j" || arg == "--threads") && hasValue && parseNumber(argv[i + 1], options.threads))
+        {
+            ++i;
+            if (options.threads == 0)
+            {
+                options.threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
+        else if ((arg == "-w" || arg == "--width") && hasValue && parseNumber(argv[i + 1], options.width))
+        {
+            ++i;
+        }
+        else if (arg == "--wide")
+        {
+            options.wide = true;
+        }
+        else if (arg == "--render-cache" && hasValue && parseNumber(argv[i + 1], options.renderCache) &&
+                 options.renderCache <= RenderCache::maxCapacity)
+        {
+            ++i;
+        }
+        else if (arg == "--stats")
+        {
+            stats = true;
+        }
+        else if (arg == "--listen" && hasValue)
+        {
+            socketPath = argv[++i];
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    if (!socketPath.empty())
+    {
+        int const status = serve(socketPath, options);
+        if (stats)
+        {
+            printStatistics(collectStatistics(), std::cerr);
+        }
+        return status;
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    MappedFile mapped{};
+    if (mapped.map(STDIN_FILENO))
+    {
+        pocketcalculator(mapped.contents(), std::cout, options);
+    }
+    else
+    {
+        pocketcalculator(std::cin, std::cout, options);
+    }
+
+    if (stats)
+    {
+        std::cout.flush();
+        printStatistics(collectStatistics(), std::cerr);
+    }
+}
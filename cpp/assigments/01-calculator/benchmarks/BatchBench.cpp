@@ -0,0 +1,138 @@
+#include "BatchCalc.hpp"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t columnSize = 1 << 20;
+
+  struct Operands
+  {
+    std::vector<int> lhs{};
+    std::vector<int> rhs{};
+    std::vector<char> ops{};
+  };
+
+  // Mostly small operands with the occasional zero divisor and overflow.
+  auto operands() -> Operands const &
+  {
+    static Operands const instance = [] {
+      std::mt19937 random{42};
+      std::uniform_int_distribution<int> operand{-100'000, 100'000};
+      std::uniform_int_distribution<int> op{0, 4};
+      Operands columns{};
+      for (std::size_t i = 0; i < columnSize; ++i)
+      {
+        columns.lhs.push_back(operand(random));
+        columns.rhs.push_back(i % 1000 == 0 ? 0 : operand(random));
+        columns.ops.push_back("+-*/%"[op(random)]);
+      }
+      return columns;
+    }();
+    return instance;
+  }
+
+  // Repeats `run` for at least half a second and prints elements/s.
+  template <typename Run>
+  auto reportElements(std::string_view name, std::size_t elements, Run &&run) -> void
+  {
+    using clock = std::chrono::steady_clock;
+    std::size_t rounds{};
+    auto const start = clock::now();
+    auto elapsed = clock::duration{};
+    do
+    {
+      run();
+      ++rounds;
+      elapsed = clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds{500});
+
+    double const seconds = std::chrono::duration<double>(elapsed).count() / static_cast<double>(rounds);
+    std::cout << name << ": " << static_cast<double>(elements) / seconds << " elements/s\n";
+  }
+
+  auto kernelName(BatchKernel kernel) -> std::string
+  {
+    switch (kernel)
+    {
+    case BatchKernel::scalar:
+      return "scalar";
+    case BatchKernel::sse41:
+      return "sse4.1";
+    case BatchKernel::avx2:
+      return "avx2";
+    }
+    return "?";
+  }
+}
+
+TEST_CASE("calcBatch per operator column", "[benchmark]")
+{
+  auto const &[lhs, rhs, ops] = operands();
+  std::vector<int> results(columnSize);
+  std::vector<CalcError> errors(columnSize);
+
+  for (char const op : {'+', '-', '*', '/', '%'})
+  {
+    auto const loop = [&] {
+      std::size_t failed{};
+      for (std::size_t i = 0; i < columnSize; ++i)
+      {
+        errors[i] = tryCalc(lhs[i], rhs[i], op, results[i]);
+        failed += errors[i] != CalcError::none;
+      }
+      return failed;
+    };
+    reportElements(std::string{"tryCalc loop, '"} + op + "'", columnSize, loop);
+
+    for (auto kernel = BatchKernel::scalar; kernel <= supportedBatchKernel();
+         kernel = static_cast<BatchKernel>(static_cast<int>(kernel) + 1))
+    {
+      auto const batch = [&] {
+        return calcBatch(lhs, rhs, op, results, errors, kernel);
+      };
+      reportElements("calcBatch " + kernelName(kernel) + ", '" + op + "'", columnSize, batch);
+    }
+  }
+
+  BENCHMARK("calcBatch '*', best kernel")
+  {
+    return calcBatch(lhs, rhs, '*', results, errors);
+  };
+}
+
+TEST_CASE("calcBatch with mixed operators", "[benchmark]")
+{
+  auto const &[lhs, rhs, ops] = operands();
+  std::vector<int> results(columnSize);
+  std::vector<CalcError> errors(columnSize);
+
+  auto const loop = [&] {
+    std::size_t failed{};
+    for (std::size_t i = 0; i < columnSize; ++i)
+    {
+      errors[i] = tryCalc(lhs[i], rhs[i], ops[i], results[i]);
+      failed += errors[i] != CalcError::none;
+    }
+    return failed;
+  };
+  auto const batch = [&] {
+    return calcBatch(lhs, rhs, ops, results, errors);
+  };
+
+  BENCHMARK("calcBatch, operator per element")
+  {
+    return batch();
+  };
+  reportElements("tryCalc loop, mixed", columnSize, loop);
+  reportElements("calcBatch, mixed", columnSize, batch);
+}
@@ -0,0 +1,231 @@
+#include "Calc.hpp"
+#include "InputGenerator.hpp"
+#include "Pocketcalculator.hpp"
+#include "RenderCache.hpp"
+#include "Sevensegment.hpp"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+  auto splitLines(std::string const &text) -> std::vector<std::string_view>
+  {
+    std::vector<std::string_view> lines{};
+    std::string_view rest{text};
+    while (!rest.empty())
+    {
+      auto const end = rest.find('\n');
+      lines.push_back(rest.substr(0, end));
+      rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    }
+    return lines;
+  }
+
+  // Repeats `run` for at least half a second and prints lines/s and bytes/s.
+  template <typename Run>
+  auto reportThroughput(std::string_view name, std::size_t lines, std::size_t bytes, Run &&run) -> void
+  {
+    using clock = std::chrono::steady_clock;
+    std::size_t rounds{};
+    auto const start = clock::now();
+    auto elapsed = clock::duration{};
+    do
+    {
+      run();
+      ++rounds;
+      elapsed = clock::now() - start;
+    } while (elapsed < std::chrono::milliseconds{500});
+
+    double const seconds = std::chrono::duration<double>(elapsed).count() / static_cast<double>(rounds);
+    std::cout << name << ": " << static_cast<double>(lines) / seconds << " lines/s, "
+              << static_cast<double>(bytes) / seconds << " bytes/s\n";
+  }
+
+  struct Workload
+  {
+    GeneratorConfig config{configFromEnvironment()};
+    std::string text{generateExpressions(config)};
+    std::vector<std::string_view> lines{splitLines(text)};
+  };
+
+  auto workload() -> Workload const &
+  {
+    static Workload const instance{};
+    return instance;
+  }
+}
+
+TEST_CASE("calc(int, int, char)", "[benchmark]")
+{
+  std::vector<Expression> expressions{};
+  for (auto const line : workload().lines)
+  {
+    Expression expr{};
+    if (tryParseExpression(line, expr) == CalcError::none)
+    {
+      expressions.push_back(expr);
+    }
+  }
+
+  auto const run = [&]
+  {
+    long sum{};
+    for (auto const &[a, op, b] : expressions)
+    {
+      try
+      {
+        sum += calc(a, b, op);
+      }
+      catch (std::invalid_argument const &)
+      {
+        --sum;
+      }
+    }
+    return sum;
+  };
+  BENCHMARK("calc(int, int, char)")
+  {
+    return run();
+  };
+  reportThroughput("calc(int, int, char)", expressions.size(), expressions.size() * sizeof(Expression), run);
+}
+
+TEST_CASE("calc(std::istream&)", "[benchmark]")
+{
+  auto const &lines = workload().lines;
+  auto const run = [&]
+  {
+    long sum{};
+    for (auto const line : lines)
+    {
+      std::istringstream in{std::string{line}};
+      try
+      {
+        sum += calc(in);
+      }
+      catch (std::invalid_argument const &)
+      {
+        --sum;
+      }
+    }
+    return sum;
+  };
+  BENCHMARK("calc(std::istream&)")
+  {
+    return run();
+  };
+  reportThroughput("calc(std::istream&)", lines.size(), workload().text.size(), run);
+}
+
+TEST_CASE("printLargeNumber / printLargeError", "[benchmark]")
+{
+  std::size_t const count = workload().lines.size();
+  std::ostringstream sink{};
+  auto const numbers = [&]
+  {
+    sink.str({});
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      printLargeNumber(static_cast<int>(i % 20'000'000) - 10'000'000, sink);
+    }
+    return sink.tellp();
+  };
+  auto const errors = [&]
+  {
+    sink.str({});
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      printLargeError(sink);
+    }
+    return sink.tellp();
+  };
+
+  BENCHMARK("printLargeNumber")
+  {
+    return numbers();
+  };
+  BENCHMARK("printLargeError")
+  {
+    return errors();
+  };
+
+  numbers();
+  reportThroughput("printLargeNumber", count, static_cast<std::size_t>(sink.tellp()), numbers);
+  errors();
+  reportThroughput("printLargeError", count, static_cast<std::size_t>(sink.tellp()), errors);
+}
+
+TEST_CASE("RenderCache vs renderLargeNumber", "[benchmark]")
+{
+  std::size_t const count = workload().lines.size();
+  std::vector<std::int64_t> results{};
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    // Mostly small totals, with a tail of distinct values.
+    results.push_back(i % 8 == 0 ? static_cast<std::int64_t>(i) : static_cast<std::int64_t>(i % 64));
+  }
+
+  char block[largeNumberMaxSize];
+  auto const render = [&]
+  {
+    std::size_t bytes{};
+    for (auto const result : results)
+    {
+      bytes += static_cast<std::size_t>(renderLargeNumber(result, block) - block);
+    }
+    return bytes;
+  };
+  RenderCache cache{256};
+  auto const cached = [&]
+  {
+    std::size_t bytes{};
+    for (auto const result : results)
+    {
+      auto const rendered = cache.number(result);
+      std::copy(rendered.begin(), rendered.end(), block);
+      bytes += rendered.size();
+    }
+    return bytes;
+  };
+
+  BENCHMARK("renderLargeNumber")
+  {
+    return render();
+  };
+  BENCHMARK("RenderCache of 256 blocks")
+  {
+    return cached();
+  };
+  reportThroughput("renderLargeNumber", count, render(), render);
+  reportThroughput("RenderCache", count, cached(), cached);
+  WARN("render cache hit rate: " << cache.hitRate());
+}
+
+TEST_CASE("pocketcalculator end to end", "[benchmark]")
+{
+  auto const &text = workload().text;
+  auto const run = [&]
+  {
+    std::istringstream input{text};
+    std::ostringstream output{};
+    pocketcalculator(input, output);
+    return output.tellp();
+  };
+  BENCHMARK("pocketcalculator(std::istream&, std::ostream&)")
+  {
+    return run();
+  };
+  reportThroughput("pocketcalculator", workload().lines.size(), text.size(), run);
+}
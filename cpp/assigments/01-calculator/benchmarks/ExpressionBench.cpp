@@ -0,0 +1,67 @@
+#include "ExpressionEngine.hpp"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  // A feed where most lines repeat one of a few hundred distinct expressions.
+  auto repetitiveFeed(std::size_t lines, std::size_t distinct) -> std::vector<std::string>
+  {
+    std::mt19937 random{42};
+    std::uniform_int_distribution<int> operand{1, 999};
+    std::vector<std::string> shapes{};
+    for (std::size_t i = 0; i < distinct; ++i)
+    {
+      shapes.push_back(std::to_string(operand(random)) + " + " + std::to_string(operand(random)) + " * (" +
+                       std::to_string(operand(random)) + " - " + std::to_string(operand(random)) + ") % 97");
+    }
+    std::uniform_int_distribution<std::size_t> pick{0, distinct - 1};
+    std::vector<std::string> feed{};
+    for (std::size_t i = 0; i < lines; ++i)
+    {
+      feed.push_back(shapes[pick(random)]);
+    }
+    return feed;
+  }
+}
+
+TEST_CASE("expression engine: cached vs re-parsed", "[benchmark]")
+{
+  auto const feed = repetitiveFeed(10'000, 256);
+
+  BENCHMARK("compile and run every line")
+  {
+    long sum{};
+    for (auto const &line : feed)
+    {
+      int result{};
+      if (evaluateExpression(line, result) == CalcError::none)
+      {
+        sum += result;
+      }
+    }
+    return sum;
+  };
+
+  ExpressionCache cache{1024};
+  BENCHMARK("LRU cache of 1024 programs")
+  {
+    long sum{};
+    for (auto const &line : feed)
+    {
+      int result{};
+      if (cache.evaluate(line, result) == CalcError::none)
+      {
+        sum += result;
+      }
+    }
+    return sum;
+  };
+  WARN("cache hit rate: " << cache.hitRate());
+}
@@ -0,0 +1,73 @@
+#ifndef INPUTGENERATOR_HPP_
+#define INPUTGENERATOR_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+struct GeneratorConfig
+{
+  std::size_t lines{100'000};
+  // Share of lines that end up as Error (bad format, /0, %0, unknown operator, too wide, overflow).
+  double errorRatio{0.3};
+  std::uint32_t seed{42};
+};
+
+// Reads POCKETCALCULATOR_BENCH_LINES and POCKETCALCULATOR_BENCH_ERROR_RATIO.
+inline auto configFromEnvironment() -> GeneratorConfig
+{
+  GeneratorConfig config{};
+  if (char const *lines = std::getenv("POCKETCALCULATOR_BENCH_LINES"))
+  {
+    config.lines = std::strtoull(lines, nullptr, 10);
+  }
+  if (char const *ratio = std::getenv("POCKETCALCULATOR_BENCH_ERROR_RATIO"))
+  {
+    config.errorRatio = std::strtod(ratio, nullptr);
+  }
+  return config;
+}
+
+// Deterministic pocketcalculator input: the same config always yields the same text.
+inline auto generateExpressions(GeneratorConfig const &config) -> std::string
+{
+  std::mt19937 random{config.seed};
+  std::bernoulli_distribution isError{config.errorRatio};
+  std::uniform_int_distribution<int> operand{-9999, 9999};
+  std::uniform_int_distribution<std::size_t> pick{0, 4};
+  std::array<char, 5> const operators{'+', '-', '*', '/', '%'};
+  // 99999*9999 fits an int but not the display; 99999*99999 overflows an int.
+  std::array<char const *, 7> const errors{"foo bar", "1+2 x", "7/0", "7%0", "3$4", "99999*9999", "99999*99999"};
+  std::uniform_int_distribution<std::size_t> pickError{0, errors.size() - 1};
+
+  std::string text{};
+  text.reserve(config.lines * 12);
+  for (std::size_t i = 0; i < config.lines; ++i)
+  {
+    if (isError(random))
+    {
+      text += errors[pickError(random)];
+    }
+    else
+    {
+      char const op = operators[pick(random)];
+      int rhs = operand(random);
+      if ((op == '/' || op == '%') && rhs == 0)
+      {
+        rhs = 1;
+      }
+      text += std::to_string(operand(random));
+      text += ' ';
+      text += op;
+      text += ' ';
+      text += std::to_string(rhs);
+    }
+    text += '\n';
+  }
+  return text;
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include "CalculatorServer.hpp"
+#include "InputGenerator.hpp"
+#include "Pocketcalculator.hpp"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  auto parseCount(std::string_view text, std::size_t &value) -> bool
+  {
+    auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc{} && end == text.data() + text.size() && value > 0;
+  }
+
+  auto usage(char const *program) -> int
+  {
+    std::cerr << "usage: " << program << " PATH [-c|--connections N] [-n|--lines N]\n"
+              << "  Opens N concurrent sessions against a PocketcalculatorApp --listen PATH\n"
+              << "  server, checks every answer against the local pocketcalculator() and\n"
+              << "  reports the aggregate throughput.\n";
+    return 1;
+  }
+}
+
+auto main(int argc, char *argv[]) -> int
+{
+  if (argc < 2)
+  {
+    return usage(argv[0]);
+  }
+  std::string const socketPath{argv[1]};
+  std::size_t connections{64};
+  GeneratorConfig config{.lines = 10'000};
+  for (int i = 2; i < argc; ++i)
+  {
+    std::string_view const arg{argv[i]};
+    bool const hasValue = i + 1 < argc;
+    if ((arg == "-c" || arg == "--connections") && hasValue && parseCount(argv[i + 1], connections))
+    {
+      ++i;
+    }
+    else if ((arg == "-n" || arg == "--lines") && hasValue && parseCount(argv[i + 1], config.lines))
+    {
+      ++i;
+    }
+    else
+    {
+      return usage(argv[0]);
+    }
+  }
+
+  std::vector<std::string> inputs{};
+  std::vector<std::string> expected{};
+  std::size_t bytes{};
+  for (std::size_t i = 0; i < connections; ++i)
+  {
+    config.seed = static_cast<std::uint32_t>(i + 1);
+    inputs.push_back(generateExpressions(config));
+    std::istringstream input{inputs.back()};
+    std::ostringstream output{};
+    pocketcalculator(input, output);
+    expected.push_back(output.str());
+    bytes += inputs.back().size();
+  }
+
+  std::atomic<std::size_t> mismatches{};
+  std::atomic<std::size_t> failures{};
+  auto const session = [&](std::size_t i)
+  {
+    try
+    {
+      if (calculateRemote(socketPath, inputs[i]) != expected[i])
+      {
+        ++mismatches;
+      }
+    }
+    catch (std::exception const &error)
+    {
+      std::cerr << error.what() << '\n';
+      ++failures;
+    }
+  };
+
+  auto const start = std::chrono::steady_clock::now();
+  {
+    std::vector<std::jthread> clients{};
+    for (std::size_t i = 0; i < connections; ++i)
+    {
+      clients.emplace_back(session, i);
+    }
+  }
+  double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::size_t const lines = connections * config.lines;
+  std::cout << connections << " sessions, " << lines << " lines in " << seconds << " s: "
+            << static_cast<double>(lines) / seconds << " lines/s, "
+            << static_cast<double>(bytes) / seconds << " bytes/s\n"
+            << mismatches << " mismatched sessions, " << failures << " failed sessions\n";
+  return mismatches == 0 && failures == 0 ? 0 : 1;
+}
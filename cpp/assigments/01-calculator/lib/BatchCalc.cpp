@@ -0,0 +1,314 @@
+#include "BatchCalc.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCHCALC_X86 1
+#include <immintrin.h>
+#else
+#define BATCHCALC_X86 0
+#endif
+
+namespace
+{
+  // Operator runs shorter than this skip the per-run dispatch and go element by element.
+  constexpr std::size_t shortRun = 16;
+
+  struct Columns
+  {
+    int const *lhs;
+    int const *rhs;
+    int *results;
+    CalcError *errors;
+    std::size_t count;
+  };
+
+  auto columns(std::span<int const> lhs, std::span<int const> rhs, std::span<int> results, std::span<CalcError> errors) -> Columns
+  {
+    if (rhs.size() != lhs.size() || results.size() != lhs.size() || errors.size() != lhs.size())
+    {
+      throw std::invalid_argument{"batch columns differ in size"};
+    }
+    return Columns{lhs.data(), rhs.data(), results.data(), errors.data(), lhs.size()};
+  }
+
+#if BATCHCALC_X86
+  // The kernels store error codes as whole vectors of int.
+  static_assert(sizeof(CalcError) == sizeof(int));
+
+  template <char Op>
+  constexpr int zeroError = static_cast<int>(Op == '%' ? CalcError::moduloByZero : CalcError::divisionByZero);
+  constexpr int overflowError = static_cast<int>(CalcError::overflow);
+
+  // Per-lane outcome: the wrapped value plus all-ones masks of the failed lanes.
+  struct SseLanes
+  {
+    __m128i value;
+    __m128i overflow;
+    __m128i zero;
+  };
+
+  struct Avx2Lanes
+  {
+    __m256i value;
+    __m256i overflow;
+    __m256i zero;
+  };
+
+  // There is no integer vector division. Every int is exact as a double and the
+  // truncated double quotient of two ints is the exact int quotient; lanes
+  // overflowing int come back as INT_MIN, which the callers flag or cancel out.
+  [[gnu::target("sse4.1")]] auto quotient(__m128i x, __m128i y) -> __m128i
+  {
+    __m128i const xHigh = _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i const yHigh = _mm_shuffle_epi32(y, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i const low = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(x), _mm_cvtepi32_pd(y)));
+    __m128i const high = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(xHigh), _mm_cvtepi32_pd(yHigh)));
+    return _mm_unpacklo_epi64(low, high);
+  }
+
+  template <char Op>
+  [[gnu::target("sse4.1")]] auto apply(__m128i x, __m128i y) -> SseLanes
+  {
+    __m128i const none = _mm_setzero_si128();
+    if constexpr (Op == '+')
+    {
+      // Overflow iff the sum differs in sign from both operands.
+      __m128i const sum = _mm_add_epi32(x, y);
+      return {sum, _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(x, sum), _mm_xor_si128(y, sum)), 31), none};
+    }
+    else if constexpr (Op == '-')
+    {
+      // Overflow iff the operands differ in sign and the difference differs from x.
+      __m128i const difference = _mm_sub_epi32(x, y);
+      return {difference, _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(x, y), _mm_xor_si128(x, difference)), 31), none};
+    }
+    else if constexpr (Op == '*')
+    {
+      // Overflow iff the high half of the 64-bit product is not the sign of the low half.
+      __m128i const product = _mm_mullo_epi32(x, y);
+      __m128i const even = _mm_mul_epi32(x, y);
+      __m128i const odd = _mm_mul_epi32(_mm_srli_epi64(x, 32), _mm_srli_epi64(y, 32));
+      __m128i const high = _mm_blend_epi16(_mm_srli_epi64(even, 32), odd, 0xCC);
+      __m128i const exact = _mm_cmpeq_epi32(high, _mm_srai_epi32(product, 31));
+      return {product, _mm_xor_si128(exact, _mm_set1_epi32(-1)), none};
+    }
+    else
+    {
+      __m128i const zero = _mm_cmpeq_epi32(y, none);
+      __m128i const divisor = _mm_blendv_epi8(y, _mm_set1_epi32(1), zero);
+      __m128i const q = quotient(x, divisor);
+      if constexpr (Op == '/')
+      {
+        __m128i const overflow = _mm_and_si128(_mm_cmpeq_epi32(x, _mm_set1_epi32(std::numeric_limits<int>::min())),
+                                               _mm_cmpeq_epi32(y, _mm_set1_epi32(-1)));
+        return {q, overflow, zero};
+      }
+      else
+      {
+        return {_mm_sub_epi32(x, _mm_mullo_epi32(q, divisor)), none, zero};
+      }
+    }
+  }
+
+  // Processes whole vectors and returns how many elements that covered.
+  template <char Op>
+  [[gnu::target("sse4.1")]] auto sse41Column(Columns const &c, std::size_t &failed) -> std::size_t
+  {
+    std::size_t i{};
+    for (; i + 4 <= c.count; i += 4)
+    {
+      __m128i const x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(c.lhs + i));
+      __m128i const y = _mm_loadu_si128(reinterpret_cast<__m128i const *>(c.rhs + i));
+      auto const lanes = apply<Op>(x, y);
+      __m128i const bad = _mm_or_si128(lanes.overflow, lanes.zero);
+      auto *const out = reinterpret_cast<__m128i *>(c.results + i);
+      _mm_storeu_si128(out, _mm_blendv_epi8(lanes.value, _mm_loadu_si128(out), bad));
+      __m128i const codes = _mm_or_si128(_mm_and_si128(lanes.overflow, _mm_set1_epi32(overflowError)),
+                                         _mm_and_si128(lanes.zero, _mm_set1_epi32(zeroError<Op>)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(c.errors + i), codes);
+      failed += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(bad)))));
+    }
+    return i;
+  }
+
+  [[gnu::target("avx2")]] auto quotient(__m256i x, __m256i y) -> __m256i
+  {
+    __m128i const low = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(x)),
+                                                          _mm256_cvtepi32_pd(_mm256_castsi256_si128(y))));
+    __m128i const high = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(x, 1)),
+                                                           _mm256_cvtepi32_pd(_mm256_extracti128_si256(y, 1))));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+  }
+
+  template <char Op>
+  [[gnu::target("avx2")]] auto apply(__m256i x, __m256i y) -> Avx2Lanes
+  {
+    __m256i const none = _mm256_setzero_si256();
+    if constexpr (Op == '+')
+    {
+      __m256i const sum = _mm256_add_epi32(x, y);
+      return {sum, _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(x, sum), _mm256_xor_si256(y, sum)), 31), none};
+    }
+    else if constexpr (Op == '-')
+    {
+      __m256i const difference = _mm256_sub_epi32(x, y);
+      return {difference, _mm256_srai_epi32(_mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, difference)), 31), none};
+    }
+    else if constexpr (Op == '*')
+    {
+      __m256i const product = _mm256_mullo_epi32(x, y);
+      __m256i const even = _mm256_mul_epi32(x, y);
+      __m256i const odd = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32));
+      __m256i const high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+      __m256i const exact = _mm256_cmpeq_epi32(high, _mm256_srai_epi32(product, 31));
+      return {product, _mm256_xor_si256(exact, _mm256_set1_epi32(-1)), none};
+    }
+    else
+    {
+      __m256i const zero = _mm256_cmpeq_epi32(y, none);
+      __m256i const divisor = _mm256_blendv_epi8(y, _mm256_set1_epi32(1), zero);
+      __m256i const q = quotient(x, divisor);
+      if constexpr (Op == '/')
+      {
+        __m256i const overflow = _mm256_and_si256(_mm256_cmpeq_epi32(x, _mm256_set1_epi32(std::numeric_limits<int>::min())),
+                                                  _mm256_cmpeq_epi32(y, _mm256_set1_epi32(-1)));
+        return {q, overflow, zero};
+      }
+      else
+      {
+        return {_mm256_sub_epi32(x, _mm256_mullo_epi32(q, divisor)), none, zero};
+      }
+    }
+  }
+
+  template <char Op>
+  [[gnu::target("avx2")]] auto avx2Column(Columns const &c, std::size_t &failed) -> std::size_t
+  {
+    std::size_t i{};
+    for (; i + 8 <= c.count; i += 8)
+    {
+      __m256i const x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(c.lhs + i));
+      __m256i const y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(c.rhs + i));
+      auto const lanes = apply<Op>(x, y);
+      __m256i const bad = _mm256_or_si256(lanes.overflow, lanes.zero);
+      auto *const out = reinterpret_cast<__m256i *>(c.results + i);
+      _mm256_storeu_si256(out, _mm256_blendv_epi8(lanes.value, _mm256_loadu_si256(out), bad));
+      __m256i const codes = _mm256_or_si256(_mm256_and_si256(lanes.overflow, _mm256_set1_epi32(overflowError)),
+                                            _mm256_and_si256(lanes.zero, _mm256_set1_epi32(zeroError<Op>)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(c.errors + i), codes);
+      failed += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(bad)))));
+    }
+    return i;
+  }
+#endif
+
+  // One operator over a whole column: the vector kernel takes the full vectors,
+  // tryCalc<Op>() the tail (or everything, for BatchKernel::scalar).
+  auto column(Columns const &c, char op, [[maybe_unused]] BatchKernel kernel) -> std::size_t
+  {
+    std::size_t failed{};
+    auto const error = visitOperation(op, [&](auto operation) {
+      constexpr char Op = decltype(operation)::value;
+      std::size_t done{};
+#if BATCHCALC_X86
+      if (kernel == BatchKernel::avx2)
+      {
+        done = avx2Column<Op>(c, failed);
+      }
+      else if (kernel == BatchKernel::sse41)
+      {
+        done = sse41Column<Op>(c, failed);
+      }
+#endif
+      for (; done < c.count; ++done)
+      {
+        c.errors[done] = tryCalc<Op>(c.lhs[done], c.rhs[done], c.results[done]);
+        failed += c.errors[done] != CalcError::none;
+      }
+      return CalcError::none;
+    });
+    if (error != CalcError::none)
+    {
+      std::fill_n(c.errors, c.count, error);
+      failed = c.count;
+    }
+    return failed;
+  }
+}
+
+auto supportedBatchKernel() -> BatchKernel
+{
+#if BATCHCALC_X86
+  static BatchKernel const best = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+      return BatchKernel::avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+      return BatchKernel::sse41;
+    }
+    return BatchKernel::scalar;
+  }();
+  return best;
+#else
+  return BatchKernel::scalar;
+#endif
+}
+
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, char op,
+               std::span<int> results, std::span<CalcError> errors) -> std::size_t
+{
+  return calcBatch(lhs, rhs, op, results, errors, supportedBatchKernel());
+}
+
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, std::span<char const> ops,
+               std::span<int> results, std::span<CalcError> errors) -> std::size_t
+{
+  return calcBatch(lhs, rhs, ops, results, errors, supportedBatchKernel());
+}
+
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, char op,
+               std::span<int> results, std::span<CalcError> errors, BatchKernel kernel) -> std::size_t
+{
+  return column(columns(lhs, rhs, results, errors), op, std::min(kernel, supportedBatchKernel()));
+}
+
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, std::span<char const> ops,
+               std::span<int> results, std::span<CalcError> errors, BatchKernel kernel) -> std::size_t
+{
+  auto const all = columns(lhs, rhs, results, errors);
+  if (ops.size() != all.count)
+  {
+    throw std::invalid_argument{"batch columns differ in size"};
+  }
+  kernel = std::min(kernel, supportedBatchKernel());
+
+  std::size_t failed{};
+  for (std::size_t first{}; first < all.count;)
+  {
+    std::size_t last = first + 1;
+    while (last < all.count && ops[last] == ops[first])
+    {
+      ++last;
+    }
+    if (last - first >= shortRun)
+    {
+      Columns const run{all.lhs + first, all.rhs + first, all.results + first, all.errors + first, last - first};
+      failed += column(run, ops[first], kernel);
+      first = last;
+      continue;
+    }
+    for (; first < last; ++first)
+    {
+      all.errors[first] = tryCalc(all.lhs[first], all.rhs[first], ops[first], all.results[first]);
+      failed += all.errors[first] != CalcError::none;
+    }
+  }
+  return failed;
+}
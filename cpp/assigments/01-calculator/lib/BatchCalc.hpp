@@ -0,0 +1,39 @@
+#ifndef BATCHCALC_HPP_
+#define BATCHCALC_HPP_
+
+#include "Calc.hpp"
+
+#include <cstddef>
+#include <span>
+
+// Instruction sets the batch kernels are written for, in ascending order.
+enum class BatchKernel
+{
+  scalar,
+  sse41,
+  avx2,
+};
+
+// The best kernel this CPU supports, detected once at first use.
+auto supportedBatchKernel() -> BatchKernel;
+
+// Columnar calc(): results[i] = lhs[i] op rhs[i], with errors[i] holding the
+// outcome of each element instead of throwing. Where errors[i] is not
+// CalcError::none, results[i] keeps its previous value. All spans must have the
+// same size (std::invalid_argument otherwise); results may alias lhs or rhs.
+// Returns the number of failed elements.
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, char op,
+               std::span<int> results, std::span<CalcError> errors) -> std::size_t;
+
+// One operator per element. Long runs of the same operator (sorted or grouped
+// columns) share a vector kernel call; short runs are evaluated element by element.
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, std::span<char const> ops,
+               std::span<int> results, std::span<CalcError> errors) -> std::size_t;
+
+// As above with an explicit kernel, clamped to supportedBatchKernel().
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, char op,
+               std::span<int> results, std::span<CalcError> errors, BatchKernel kernel) -> std::size_t;
+auto calcBatch(std::span<int const> lhs, std::span<int const> rhs, std::span<char const> ops,
+               std::span<int> results, std::span<CalcError> errors, BatchKernel kernel) -> std::size_t;
+
+#endif
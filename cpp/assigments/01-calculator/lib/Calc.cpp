@@ -2,30 +2,96 @@
 #include "Calc.hpp"
 #include <stdexcept>
 #include <string>
-#include <limits>
 #include <istream>
+#include <charconv>
 
-auto calc(int x, int y, char op) -> int
+namespace {
+
+constexpr auto isSpace(char c) -> bool
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+auto skipSpace(char const *first, char const *last) -> char const *
+{
+  while (first != last && isSpace(*first)) {
+    ++first;
+  }
+  return first;
+}
+
+// Mirrors operator>>(int&): optional sign, decimal digits, fails on overflow.
+template <typename T>
+auto parseInt(char const *&first, char const *last, T &value) -> bool
 {
-  switch (op) {
-  case '+':
-    return x + y;
-  case '-':
-    return x - y;
-  case '*':
-    return x * y;
-  case '/':
-    if (y == 0)
-      throw std::invalid_argument("Error: Division duch 0");
-    return x / y;
-  case '%':
-    if (y == 0)
-      throw std::invalid_argument("Error: Modulo mit 0, wa willsch?");
-    return x % y;
+  char const *digits = skipSpace(first, last);
+  if (digits != last && *digits == '+') {
+    ++digits;
+    if (digits == last || *digits < '0' || *digits > '9') {
+      return false;
+    }
+  }
+  auto const [end, error] = std::from_chars(digits, last, value);
+  if (error != std::errc{}) {
+    return false;
+  }
+  first = end;
+  return true;
+}
 
-  default:
-    throw std::invalid_argument{ "unknown operator" };
+template <typename Expr>
+auto parse(std::string_view line, Expr &expr) -> CalcError
+{
+  char const *first = line.data();
+  char const *const last = first + line.size();
+  if (!parseInt(first, last, expr.lhs)) {
+    return CalcError::invalidFormat;
   }
+  first = skipSpace(first, last);
+  if (first == last) {
+    return CalcError::invalidFormat;
+  }
+  expr.op = *first++;
+  if (!parseInt(first, last, expr.rhs)) {
+    return CalcError::invalidFormat;
+  }
+  if (skipSpace(first, last) != last) {
+    return CalcError::trailingCharacters;
+  }
+  return CalcError::none;
+}
+
+}
+
+auto message(CalcError error) -> char const *
+{
+  switch (error) {
+  case CalcError::none:
+    return "no error";
+  case CalcError::invalidFormat:
+    return "invalid format";
+  case CalcError::trailingCharacters:
+    return "trailing characters";
+  case CalcError::divisionByZero:
+    return "Error: Division duch 0";
+  case CalcError::moduloByZero:
+    return "Error: Modulo mit 0, wa willsch?";
+  case CalcError::unknownOperator:
+    return "unknown operator";
+  case CalcError::overflow:
+    return "overflow";
+  }
+  return "unknown error";
+}
+
+auto tryParseExpression(std::string_view line, Expression &expr) -> CalcError
+{
+  return parse(line, expr);
+}
+
+auto tryParseExpression(std::string_view line, WideExpression &expr) -> CalcError
+{
+  return parse(line, expr);
 }
 
 auto calc(std::istream& in) -> int
@@ -33,11 +99,20 @@ auto calc(std::istream& in) -> int
   int a{}, b{};
   char op{};
   if (!(in >> a >> op >> b)) {
-    throw std::invalid_argument{ "invalid format" };
+    throw std::invalid_argument{ message(CalcError::invalidFormat) };
   }
   in >> std::ws;
   if (in.peek() != std::char_traits<char>::eof()) {
-    throw std::invalid_argument{ "trailing characters" };
+    throw std::invalid_argument{ message(CalcError::trailingCharacters) };
   }
   return calc(a, b, op);
 }
+
+auto parseExpression(std::string_view line) -> Expression
+{
+  Expression expr{};
+  if (auto const error = tryParseExpression(line, expr); error != CalcError::none) {
+    throw std::invalid_argument{ message(error) };
+  }
+  return expr;
+}
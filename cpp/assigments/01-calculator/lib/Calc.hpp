@@ -1,9 +1,178 @@
 #ifndef CALC_HPP
 #define CALC_HPP
 
+#include <concepts>
+#include <cstdint>
 #include <iosfwd>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+struct Expression
+{
+  int lhs;
+  char op;
+  int rhs;
+};
+
+struct WideExpression
+{
+  std::int64_t lhs;
+  char op;
+  std::int64_t rhs;
+};
+
+enum class CalcError
+{
+  none,
+  invalidFormat,
+  trailingCharacters,
+  divisionByZero,
+  moduloByZero,
+  unknownOperator,
+  overflow,
+};
+
+auto message(CalcError error) -> char const *;
+
+// The operators, one specialization each, so a known operator costs no dispatch.
+// Arithmetic is overflow-checked; on error `result` is left untouched.
+template <char Op>
+struct Operation;
+
+template <>
+struct Operation<'+'>
+{
+  template <std::signed_integral T>
+  static constexpr auto apply(T x, T y, T &result) -> CalcError
+  {
+    T value{};
+    if (__builtin_add_overflow(x, y, &value))
+      return CalcError::overflow;
+    result = value;
+    return CalcError::none;
+  }
+};
+
+template <>
+struct Operation<'-'>
+{
+  template <std::signed_integral T>
+  static constexpr auto apply(T x, T y, T &result) -> CalcError
+  {
+    T value{};
+    if (__builtin_sub_overflow(x, y, &value))
+      return CalcError::overflow;
+    result = value;
+    return CalcError::none;
+  }
+};
+
+template <>
+struct Operation<'*'>
+{
+  template <std::signed_integral T>
+  static constexpr auto apply(T x, T y, T &result) -> CalcError
+  {
+    T value{};
+    if (__builtin_mul_overflow(x, y, &value))
+      return CalcError::overflow;
+    result = value;
+    return CalcError::none;
+  }
+};
+
+template <>
+struct Operation<'/'>
+{
+  template <std::signed_integral T>
+  static constexpr auto apply(T x, T y, T &result) -> CalcError
+  {
+    if (y == 0)
+      return CalcError::divisionByZero;
+    if (x == std::numeric_limits<T>::min() && y == -1)
+      return CalcError::overflow;
+    result = x / y;
+    return CalcError::none;
+  }
+};
+
+template <>
+struct Operation<'%'>
+{
+  template <std::signed_integral T>
+  static constexpr auto apply(T x, T y, T &result) -> CalcError
+  {
+    if (y == 0)
+      return CalcError::moduloByZero;
+    result = y == -1 ? 0 : x % y;
+    return CalcError::none;
+  }
+};
+
+// Calls f(std::integral_constant<char, Op>{}) for the runtime operator, so a loop
+// inside f is instantiated once per operator instead of switching per element.
+template <typename F>
+constexpr auto visitOperation(char op, F &&f) -> CalcError
+{
+  switch (op) {
+  case '+':
+    return f(std::integral_constant<char, '+'>{});
+  case '-':
+    return f(std::integral_constant<char, '-'>{});
+  case '*':
+    return f(std::integral_constant<char, '*'>{});
+  case '/':
+    return f(std::integral_constant<char, '/'>{});
+  case '%':
+    return f(std::integral_constant<char, '%'>{});
+
+  default:
+    return CalcError::unknownOperator;
+  }
+}
+
+// Non-throwing variants: on CalcError::none the out parameter holds the result.
+template <char Op, std::signed_integral T>
+constexpr auto tryCalc(T x, T y, T &result) -> CalcError
+{
+  return Operation<Op>::apply(x, y, result);
+}
+
+template <std::signed_integral T>
+constexpr auto tryCalc(T x, T y, char op, T &result) -> CalcError
+{
+  return visitOperation(op, [&](auto operation) { return tryCalc<decltype(operation)::value>(x, y, result); });
+}
+
+auto tryParseExpression(std::string_view line, Expression &expr) -> CalcError;
+auto tryParseExpression(std::string_view line, WideExpression &expr) -> CalcError;
+
+// Throwing wrappers, report failures as std::invalid_argument{message(error)}.
+// In a constant expression a failing calculation is a compile error.
+template <char Op, std::signed_integral T>
+constexpr auto calc(T x, T y) -> T
+{
+  T result{};
+  if (auto const error = tryCalc<Op>(x, y, result); error != CalcError::none) {
+    throw std::invalid_argument{ message(error) };
+  }
+  return result;
+}
+
+constexpr auto calc(int x, int y, char op) -> int
+{
+  int result{};
+  if (auto const error = tryCalc(x, y, op, result); error != CalcError::none) {
+    throw std::invalid_argument{ message(error) };
+  }
+  return result;
+}
 
-auto calc(int, int, char) -> int;
 auto calc(std::istream &in) -> int;
 
-#endif
\ No newline at end of file
+// Accepts and rejects exactly what calc(std::istream&) does, without a stream.
+auto parseExpression(std::string_view line) -> Expression;
+
+#endif
@@ -0,0 +1,434 @@
+#include "CalculatorServer.hpp"
+#include "Instrumentation.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+  constexpr std::size_t readSize = 64 * 1024;
+  // A session stops reading while more than this much output is unsent, and
+  // is cut off once an unterminated line grows beyond it.
+  constexpr std::size_t highWater = 1024 * 1024;
+
+  [[noreturn]] auto fail(char const *what) -> void
+  {
+    throw std::system_error{errno, std::generic_category(), what};
+  }
+
+  auto address(std::string const &path) -> sockaddr_un
+  {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    {
+      throw std::invalid_argument{"invalid socket path"};
+    }
+    std::copy(path.begin(), path.end(), addr.sun_path);
+    return addr;
+  }
+
+  auto wouldBlock() -> bool
+  {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  }
+
+  struct Descriptor
+  {
+    int fd;
+    ~Descriptor()
+    {
+      if (fd >= 0)
+      {
+        ::close(fd);
+      }
+    }
+  };
+
+  // Renders every complete line of `input` and drops it; at end of input the
+  // unterminated rest counts as a line too, as with std::getline.
+  auto renderLines(std::string &input, std::string &output, RenderCache &cache, PocketcalculatorOptions const &options, bool final) -> void
+  {
+    std::string_view const text{input};
+    std::size_t consumed{};
+    for (auto end = text.find('\n'); end != std::string_view::npos; end = text.find('\n', consumed))
+    {
+      output.append(renderCalculation(text.substr(consumed, end - consumed), cache, options));
+      consumed = end + 1;
+    }
+    if (final && consumed < text.size())
+    {
+      output.append(renderCalculation(text.substr(consumed), cache, options));
+      consumed = text.size();
+    }
+    input.erase(0, consumed);
+  }
+}
+
+CalculatorServer::CalculatorServer(std::string socketPath, PocketcalculatorOptions options)
+    : socketPath{std::move(socketPath)}, options{options}, cache{options.renderCache, options.width}
+{
+  auto const addr = address(this->socketPath);
+  Descriptor listening{socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+  Descriptor polling{epoll_create1(EPOLL_CLOEXEC)};
+  Descriptor waking{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+  if (listening.fd < 0 || polling.fd < 0 || waking.fd < 0)
+  {
+    fail("socket");
+  }
+
+  struct stat info{};
+  if (lstat(this->socketPath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+  {
+    unlink(this->socketPath.c_str());
+  }
+  if (bind(listening.fd, reinterpret_cast<sockaddr const *>(&addr), sizeof(addr)) != 0)
+  {
+    fail("bind");
+  }
+  if (listen(listening.fd, SOMAXCONN) != 0)
+  {
+    fail("listen");
+  }
+
+  for (int const fd : {listening.fd, waking.fd})
+  {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(polling.fd, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+      fail("epoll_ctl");
+    }
+  }
+
+  listener = std::exchange(listening.fd, -1);
+  events = std::exchange(polling.fd, -1);
+  wakeup = std::exchange(waking.fd, -1);
+  spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+CalculatorServer::~CalculatorServer()
+{
+  for (auto const &[fd, session] : sessions)
+  {
+    ::close(fd);
+  }
+  if (spare >= 0)
+  {
+    ::close(spare);
+  }
+  ::close(wakeup);
+  ::close(events);
+  ::close(listener);
+  unlink(socketPath.c_str());
+}
+
+auto CalculatorServer::run() -> void
+{
+  std::array<epoll_event, 64> ready;
+  bool running = true;
+  while (running)
+  {
+    int const count = epoll_wait(events, ready.data(), static_cast<int>(ready.size()), -1);
+    if (count < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      fail("epoll_wait");
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+      int const fd = ready[static_cast<std::size_t>(i)].data.fd;
+      auto const mask = ready[static_cast<std::size_t>(i)].events;
+      if (fd == listener)
+      {
+        accept();
+        continue;
+      }
+      if (fd == wakeup)
+      {
+        std::uint64_t value{};
+        [[maybe_unused]] auto const drained = ::read(wakeup, &value, sizeof(value));
+        running = false;
+        continue;
+      }
+
+      auto const found = sessions.find(fd);
+      if (found == sessions.end())
+      {
+        continue;
+      }
+      Session &session = found->second;
+      bool const alive = (mask & EPOLLERR) == 0 &&
+                         receive(fd, session) &&
+                         send(fd, session) &&
+                         update(fd, session);
+      if (!alive)
+      {
+        close(fd);
+      }
+    }
+  }
+}
+
+auto CalculatorServer::stop() -> void
+{
+  std::uint64_t const one{1};
+  [[maybe_unused]] auto const written = ::write(wakeup, &one, sizeof(one));
+}
+
+auto CalculatorServer::accept() -> void
+{
+  while (true)
+  {
+    int const fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      if (errno == EMFILE || errno == ENFILE)
+      {
+        if (shed())
+        {
+          continue;
+        }
+        // Nothing left to shed with: wait for a session to close instead.
+        if (spare < 0)
+        {
+          watchListener(false);
+        }
+      }
+      return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(events, EPOLL_CTL_ADD, fd, &event) != 0)
+    {
+      ::close(fd);
+      continue;
+    }
+    sessions[fd] = Session{.interest = EPOLLIN};
+  }
+}
+
+// Out of descriptors, a pending connection stays queued and the level-triggered
+// listener would wake epoll_wait forever. Giving up the spare descriptor makes
+// room to accept the connection and close it right away.
+auto CalculatorServer::shed() -> bool
+{
+  if (spare < 0)
+  {
+    return false;
+  }
+  ::close(spare);
+  int const fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+  if (fd >= 0)
+  {
+    ::close(fd);
+  }
+  spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  return fd >= 0;
+}
+
+auto CalculatorServer::watchListener(bool watch) -> void
+{
+  epoll_event event{};
+  event.events = watch ? unsigned{EPOLLIN} : 0u;
+  event.data.fd = listener;
+  if (epoll_ctl(events, EPOLL_CTL_MOD, listener, &event) == 0)
+  {
+    listening = watch;
+  }
+}
+
+auto CalculatorServer::receive(int fd, Session &session) -> bool
+{
+  char buffer[readSize];
+  while (!session.inputDone && session.output.size() - session.written < highWater)
+  {
+    auto const got = ::read(fd, buffer, sizeof(buffer));
+    if (got > 0)
+    {
+      session.input.append(buffer, static_cast<std::size_t>(got));
+      renderLines(session.input, session.output, cache, options, false);
+      // No calculation is this long; answer Error and stop reading rather
+      // than buffer the line without bound.
+      if (session.input.size() > highWater)
+      {
+        countError(ErrorCategory::invalidFormat);
+        session.output.append(RenderCache::error());
+        session.input = std::string{};
+        session.inputDone = true;
+      }
+    }
+    else if (got == 0)
+    {
+      session.inputDone = true;
+      renderLines(session.input, session.output, cache, options, true);
+    }
+    else if (errno != EINTR)
+    {
+      return wouldBlock();
+    }
+  }
+  return true;
+}
+
+auto CalculatorServer::send(int fd, Session &session) -> bool
+{
+  while (session.written < session.output.size())
+  {
+    auto const sent = ::send(fd, session.output.data() + session.written, session.output.size() - session.written, MSG_NOSIGNAL);
+    if (sent >= 0)
+    {
+      session.written += static_cast<std::size_t>(sent);
+    }
+    else if (errno != EINTR)
+    {
+      return wouldBlock();
+    }
+  }
+  session.output.clear();
+  session.written = 0;
+  return true;
+}
+
+auto CalculatorServer::update(int fd, Session &session) -> bool
+{
+  std::size_t const pending = session.output.size() - session.written;
+  if (session.inputDone && pending == 0)
+  {
+    return false;
+  }
+
+  unsigned interest{};
+  if (pending > 0)
+  {
+    interest |= EPOLLOUT;
+  }
+  if (!session.inputDone && pending < highWater)
+  {
+    interest |= EPOLLIN;
+  }
+  if (interest != session.interest)
+  {
+    epoll_event event{};
+    event.events = interest;
+    event.data.fd = fd;
+    if (epoll_ctl(events, EPOLL_CTL_MOD, fd, &event) != 0)
+    {
+      return false;
+    }
+    session.interest = interest;
+  }
+  return true;
+}
+
+auto CalculatorServer::close(int fd) -> void
+{
+  epoll_ctl(events, EPOLL_CTL_DEL, fd, nullptr);
+  ::close(fd);
+  sessions.erase(fd);
+  if (spare < 0)
+  {
+    spare = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  }
+  if (!listening)
+  {
+    watchListener(true);
+  }
+}
+
+auto calculateRemote(std::string const &socketPath, std::string_view input) -> std::string
+{
+  auto const addr = address(socketPath);
+  Descriptor connection{socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+  if (connection.fd < 0)
+  {
+    fail("socket");
+  }
+  if (connect(connection.fd, reinterpret_cast<sockaddr const *>(&addr), sizeof(addr)) != 0)
+  {
+    fail("connect");
+  }
+
+  std::string output{};
+  char buffer[readSize];
+  std::size_t sent{};
+  bool writing = true;
+  while (true)
+  {
+    if (writing && sent == input.size())
+    {
+      shutdown(connection.fd, SHUT_WR);
+      writing = false;
+    }
+
+    pollfd ready{connection.fd, static_cast<short>(writing ? POLLIN | POLLOUT : POLLIN), 0};
+    if (poll(&ready, 1, -1) < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      fail("poll");
+    }
+
+    if (writing && (ready.revents & POLLOUT))
+    {
+      auto const count = ::send(connection.fd, input.data() + sent, input.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (count >= 0)
+      {
+        sent += static_cast<std::size_t>(count);
+      }
+      else if (errno == EPIPE || errno == ECONNRESET)
+      {
+        // The server stopped reading, e.g. after an overlong line; its answer
+        // is still waiting to be received.
+        writing = false;
+      }
+      else if (errno != EINTR && !wouldBlock())
+      {
+        fail("send");
+      }
+    }
+    if (ready.revents & (POLLIN | POLLHUP | POLLERR))
+    {
+      auto const count = recv(connection.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+      if (count > 0)
+      {
+        output.append(buffer, static_cast<std::size_t>(count));
+      }
+      else if (count == 0 || errno == ECONNRESET)
+      {
+        // A server that stopped reading resets the connection after its answer.
+        return output;
+      }
+      else if (errno != EINTR && !wouldBlock())
+      {
+        fail("recv");
+      }
+    }
+  }
+}
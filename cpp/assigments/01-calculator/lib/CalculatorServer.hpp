@@ -0,0 +1,64 @@
+#ifndef CALCULATORSERVER_HPP_
+#define CALCULATORSERVER_HPP_
+
+#include "Pocketcalculator.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Serves pocketcalculator sessions on a Unix domain socket: every connection
+// gets the output pocketcalculator() would produce for the bytes it sends.
+// One epoll loop multiplexes all connections with non-blocking I/O. A session
+// sending a line longer than the output limit gets an Error block and is closed.
+class CalculatorServer
+{
+public:
+  // Binds and listens; throws std::system_error on failure.
+  CalculatorServer(std::string socketPath, PocketcalculatorOptions options);
+  ~CalculatorServer();
+
+  CalculatorServer(CalculatorServer const &) = delete;
+  auto operator=(CalculatorServer const &) -> CalculatorServer & = delete;
+
+  // Runs the event loop until stop() is called.
+  auto run() -> void;
+  // May be called from any thread or a signal handler.
+  auto stop() -> void;
+
+private:
+  struct Session
+  {
+    std::string input{};
+    std::string output{};
+    std::size_t written{};
+    unsigned interest{};
+    // The peer half-closed, or sent a line too long to buffer.
+    bool inputDone{};
+  };
+
+  auto accept() -> void;
+  auto shed() -> bool;
+  auto watchListener(bool watch) -> void;
+  auto receive(int fd, Session &session) -> bool;
+  auto send(int fd, Session &session) -> bool;
+  auto update(int fd, Session &session) -> bool;
+  auto close(int fd) -> void;
+
+  std::string socketPath;
+  PocketcalculatorOptions options;
+  RenderCache cache;
+  int listener{-1};
+  int events{-1};
+  int wakeup{-1};
+  // Held back so a connection can still be accepted and shed when out of descriptors.
+  int spare{-1};
+  bool listening{true};
+  std::unordered_map<int, Session> sessions{};
+};
+
+// Client side: sends `input`, half-closes and returns everything the server answered.
+auto calculateRemote(std::string const &socketPath, std::string_view input) -> std::string;
+
+#endif
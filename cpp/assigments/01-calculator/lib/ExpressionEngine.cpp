@@ -0,0 +1,297 @@
+#include "ExpressionEngine.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <iterator>
+
+namespace
+{
+  constexpr std::size_t maxNesting = 256;
+
+  constexpr auto isSpace(char c) -> bool
+  {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  constexpr auto isDigit(char c) -> bool
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  // Recursive descent over
+  //   expression := term (('+' | '-') term)*
+  //   term       := factor (('*' | '/' | '%') factor)*
+  //   factor     := number | ('+' | '-') factor | '(' expression ')'
+  // emitting postfix code. A sign directly followed by a digit is part of the
+  // literal, as with operator>>(int&), so "-2147483648" stays representable.
+  class Compiler
+  {
+  public:
+    Compiler(std::string_view text, Program &program)
+        : cursor{text.data()}, last{text.data() + text.size()}, program{program}
+    {
+    }
+
+    auto compile() -> CalcError
+    {
+      program.code.clear();
+      program.depth = 0;
+      if (auto const error = expression(0); error != CalcError::none)
+      {
+        return error;
+      }
+      skipSpace();
+      return cursor == last ? CalcError::none : CalcError::trailingCharacters;
+    }
+
+  private:
+    auto expression(std::size_t nesting) -> CalcError
+    {
+      if (auto const error = term(nesting); error != CalcError::none)
+      {
+        return error;
+      }
+      while (skipSpace(), cursor != last && (*cursor == '+' || *cursor == '-'))
+      {
+        char const op = *cursor++;
+        if (auto const error = term(nesting); error != CalcError::none)
+        {
+          return error;
+        }
+        apply(op);
+      }
+      return CalcError::none;
+    }
+
+    auto term(std::size_t nesting) -> CalcError
+    {
+      if (auto const error = factor(nesting); error != CalcError::none)
+      {
+        return error;
+      }
+      while (skipSpace(), cursor != last && (*cursor == '*' || *cursor == '/' || *cursor == '%'))
+      {
+        char const op = *cursor++;
+        if (auto const error = factor(nesting); error != CalcError::none)
+        {
+          return error;
+        }
+        apply(op);
+      }
+      return CalcError::none;
+    }
+
+    auto factor(std::size_t nesting) -> CalcError
+    {
+      skipSpace();
+      if (cursor == last || nesting > maxNesting)
+      {
+        return CalcError::invalidFormat;
+      }
+
+      char const c = *cursor;
+      bool const signedLiteral = (c == '+' || c == '-') && cursor + 1 != last && isDigit(cursor[1]);
+      if (isDigit(c) || signedLiteral)
+      {
+        return literal();
+      }
+      if (c == '+')
+      {
+        ++cursor;
+        return factor(nesting + 1);
+      }
+      if (c == '-')
+      {
+        ++cursor;
+        push(0);
+        if (auto const error = factor(nesting + 1); error != CalcError::none)
+        {
+          return error;
+        }
+        apply('-');
+        return CalcError::none;
+      }
+      if (c == '(')
+      {
+        ++cursor;
+        if (auto const error = expression(nesting + 1); error != CalcError::none)
+        {
+          return error;
+        }
+        skipSpace();
+        if (cursor == last || *cursor != ')')
+        {
+          return CalcError::invalidFormat;
+        }
+        ++cursor;
+        return CalcError::none;
+      }
+      return CalcError::invalidFormat;
+    }
+
+    auto literal() -> CalcError
+    {
+      if (*cursor == '+')
+      {
+        ++cursor;
+      }
+      int value{};
+      auto const [end, error] = std::from_chars(cursor, last, value);
+      if (error != std::errc{})
+      {
+        return CalcError::invalidFormat;
+      }
+      cursor = end;
+      push(value);
+      return CalcError::none;
+    }
+
+    auto skipSpace() -> void
+    {
+      while (cursor != last && isSpace(*cursor))
+      {
+        ++cursor;
+      }
+    }
+
+    auto push(int value) -> void
+    {
+      program.code.push_back(Instruction{0, value});
+      program.depth = std::max(program.depth, ++depth);
+    }
+
+    auto apply(char op) -> void
+    {
+      program.code.push_back(Instruction{op, 0});
+      --depth;
+    }
+
+    char const *cursor;
+    char const *const last;
+    Program &program;
+    std::size_t depth{};
+  };
+}
+
+auto compileExpression(std::string_view text, Program &program) -> CalcError
+{
+  return Compiler{text, program}.compile();
+}
+
+auto runProgram(Program const &program, int &result) -> CalcError
+{
+  std::array<int, 32> small;
+  std::vector<int> large{};
+  int *stack = small.data();
+  if (program.depth > small.size())
+  {
+    large.resize(program.depth);
+    stack = large.data();
+  }
+
+  std::size_t top{};
+  for (auto const &instruction : program.code)
+  {
+    if (instruction.op == 0)
+    {
+      stack[top++] = instruction.value;
+      continue;
+    }
+    int const rhs = stack[--top];
+    if (auto const error = tryCalc(stack[top - 1], rhs, instruction.op, stack[top - 1]); error != CalcError::none)
+    {
+      return error;
+    }
+  }
+  if (top != 1)
+  {
+    return CalcError::invalidFormat;
+  }
+  result = stack[0];
+  return CalcError::none;
+}
+
+auto evaluateExpression(std::string_view text, int &result) -> CalcError
+{
+  Program program{};
+  if (auto const error = compileExpression(text, program); error != CalcError::none)
+  {
+    return error;
+  }
+  return runProgram(program, result);
+}
+
+auto normalizeExpression(std::string_view text, std::string &normalized) -> void
+{
+  normalized.resize(text.size());
+  char *const first = normalized.data();
+  char *out = first;
+  bool pendingSpace = false;
+  for (char const c : text)
+  {
+    if (isSpace(c))
+    {
+      pendingSpace = out != first;
+      continue;
+    }
+    if (pendingSpace)
+    {
+      *out++ = ' ';
+      pendingSpace = false;
+    }
+    *out++ = c;
+  }
+  normalized.resize(static_cast<std::size_t>(out - first));
+}
+
+ExpressionCache::ExpressionCache(std::size_t capacity)
+    : capacity{capacity}
+{
+  index.reserve(capacity);
+}
+
+auto ExpressionCache::evaluate(std::string_view text, int &result) -> CalcError
+{
+  normalizeExpression(text, scratch);
+
+  if (auto const found = index.find(scratch); found != index.end())
+  {
+    ++hitCount;
+    entries.splice(entries.begin(), entries, found->second);
+  }
+  else
+  {
+    ++missCount;
+    if (capacity == 0)
+    {
+      return evaluateExpression(scratch, result);
+    }
+    if (entries.size() == capacity)
+    {
+      index.erase(entries.back().key);
+      entries.splice(entries.begin(), entries, std::prev(entries.end()));
+    }
+    else
+    {
+      entries.emplace_front();
+    }
+    Entry &entry = entries.front();
+    entry.key.assign(scratch);
+    entry.compileError = compileExpression(entry.key, entry.program);
+    index.emplace(entry.key, entries.begin());
+  }
+
+  Entry const &entry = entries.front();
+  if (entry.compileError != CalcError::none)
+  {
+    return entry.compileError;
+  }
+  return runProgram(entry.program, result);
+}
+
+auto ExpressionCache::hitRate() const -> double
+{
+  auto const lookups = hitCount + missCount;
+  return lookups == 0 ? 0.0 : static_cast<double>(hitCount) / static_cast<double>(lookups);
+}
@@ -0,0 +1,67 @@
+#ifndef EXPRESSIONENGINE_HPP_
+#define EXPRESSIONENGINE_HPP_
+
+#include "Calc.hpp"
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// One stack-machine step: op == 0 pushes value, otherwise op pops two operands
+// and pushes calc(lhs, rhs, op).
+struct Instruction
+{
+  char op;
+  int value;
+};
+
+struct Program
+{
+  std::vector<Instruction> code{};
+  std::size_t depth{};
+};
+
+// Compiles `+ - * / %` with the usual precedence, unary signs and parentheses.
+auto compileExpression(std::string_view text, Program &program) -> CalcError;
+
+// Runs a compiled program with the overflow and division semantics of tryCalc().
+auto runProgram(Program const &program, int &result) -> CalcError;
+
+auto evaluateExpression(std::string_view text, int &result) -> CalcError;
+
+// Trims the text and collapses every whitespace run to a single blank.
+auto normalizeExpression(std::string_view text, std::string &normalized) -> void;
+
+class ExpressionCache
+{
+public:
+  explicit ExpressionCache(std::size_t capacity);
+
+  // Like evaluateExpression(), but reuses the compiled program of recently seen text.
+  auto evaluate(std::string_view text, int &result) -> CalcError;
+
+  auto hits() const -> std::size_t { return hitCount; }
+  auto misses() const -> std::size_t { return missCount; }
+  auto hitRate() const -> double;
+  auto size() const -> std::size_t { return entries.size(); }
+
+private:
+  struct Entry
+  {
+    std::string key;
+    Program program;
+    CalcError compileError;
+  };
+
+  std::size_t capacity;
+  std::list<Entry> entries{};
+  std::unordered_map<std::string_view, std::list<Entry>::iterator> index{};
+  std::string scratch{};
+  std::size_t hitCount{};
+  std::size_t missCount{};
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "Instrumentation.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace
+{
+  std::mutex registryMutex{};
+  std::vector<ThreadCounters const *> registry{};
+  Statistics retired{};
+
+  auto add(Statistics &sum, ThreadCounters const &counters) -> void
+  {
+    sum.lines += counters.lines.load(std::memory_order_relaxed);
+    sum.renderCacheHits += counters.renderCacheHits.load(std::memory_order_relaxed);
+    sum.renderCacheMisses += counters.renderCacheMisses.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < errorCategoryCount; ++i)
+    {
+      sum.errors[i] += counters.errors[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t stage = 0; stage < stageCount; ++stage)
+    {
+      for (std::size_t bucket = 0; bucket < latencyBuckets; ++bucket)
+      {
+        sum.latency[stage][bucket] += counters.latency[stage][bucket].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Registers the calling thread's counters and folds them into `retired` at thread exit.
+  struct RegisteredCounters
+  {
+    ThreadCounters counters{};
+
+    RegisteredCounters()
+    {
+      std::lock_guard lock{registryMutex};
+      registry.push_back(&counters);
+    }
+
+    ~RegisteredCounters()
+    {
+      std::lock_guard lock{registryMutex};
+      add(retired, counters);
+      registry.erase(std::find(registry.begin(), registry.end(), &counters));
+    }
+  };
+
+  constexpr std::array<char const *, stageCount> stageNames{
+      "read", "parse", "calc", "width check", "render", "error path"};
+  constexpr std::array<char const *, errorCategoryCount> errorNames{
+      "invalid format", "trailing characters", "division by zero", "modulo by zero",
+      "unknown operator", "overflow", "too wide"};
+
+  // Upper bound (exclusive, in ns) of the bucket holding the given quantile.
+  auto quantile(std::array<std::uint64_t, latencyBuckets> const &buckets, std::uint64_t total, double q) -> std::uint64_t
+  {
+    auto const rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1));
+    std::uint64_t seen{};
+    for (std::size_t bucket = 0; bucket < latencyBuckets; ++bucket)
+    {
+      seen += buckets[bucket];
+      if (seen > rank)
+      {
+        return bucket + 1 < latencyBuckets ? std::uint64_t{2} << bucket : ~std::uint64_t{};
+      }
+    }
+    return ~std::uint64_t{};
+  }
+}
+
+auto categoryOf(CalcError error) -> ErrorCategory
+{
+  switch (error)
+  {
+  case CalcError::trailingCharacters:
+    return ErrorCategory::trailingCharacters;
+  case CalcError::divisionByZero:
+    return ErrorCategory::divisionByZero;
+  case CalcError::moduloByZero:
+    return ErrorCategory::moduloByZero;
+  case CalcError::unknownOperator:
+    return ErrorCategory::unknownOperator;
+  case CalcError::overflow:
+    return ErrorCategory::overflow;
+  case CalcError::none:
+  case CalcError::invalidFormat:
+    break;
+  }
+  return ErrorCategory::invalidFormat;
+}
+
+auto threadCounters() -> ThreadCounters &
+{
+  thread_local RegisteredCounters registered{};
+  return registered.counters;
+}
+
+auto collectStatistics() -> Statistics
+{
+  std::lock_guard lock{registryMutex};
+  Statistics sum = retired;
+  for (auto const *counters : registry)
+  {
+    add(sum, *counters);
+  }
+  return sum;
+}
+
+auto printStatistics(Statistics const &statistics, std::ostream &out) -> void
+{
+  if constexpr (!statisticsEnabled)
+  {
+    out << "statistics are disabled, rebuild with POCKETCALCULATOR_STATS=ON\n";
+    return;
+  }
+
+  out << "lines: " << statistics.lines << '\n';
+  out << "render cache: " << statistics.renderCacheHits << " hits, " << statistics.renderCacheMisses << " misses\n";
+  for (std::size_t i = 0; i < errorCategoryCount; ++i)
+  {
+    out << "errors, " << errorNames[i] << ": " << statistics.errors[i] << '\n';
+  }
+  for (std::size_t stage = 0; stage < stageCount; ++stage)
+  {
+    auto const &buckets = statistics.latency[stage];
+    std::uint64_t total{};
+    for (auto const count : buckets)
+    {
+      total += count;
+    }
+    out << "latency, " << stageNames[stage] << ": " << total << " samples";
+    if (total != 0)
+    {
+      out << ", p50 < " << quantile(buckets, total, 0.5) << " ns"
+          << ", p99 < " << quantile(buckets, total, 0.99) << " ns"
+          << ", max < " << quantile(buckets, total, 1.0) << " ns";
+    }
+    out << '\n';
+  }
+}
@@ -0,0 +1,138 @@
+#ifndef INSTRUMENTATION_HPP_
+#define INSTRUMENTATION_HPP_
+
+#include "Calc.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+// Hot-path counters and latency histograms for pocketcalculator(). Built with
+// POCKETCALCULATOR_STATS (CMake option of the same name); otherwise every hook
+// below compiles to nothing.
+#ifdef POCKETCALCULATOR_STATS
+inline constexpr bool statisticsEnabled = true;
+#else
+inline constexpr bool statisticsEnabled = false;
+#endif
+
+enum class Stage
+{
+  read,
+  parse,
+  calc,
+  widthCheck,
+  render,
+  error,
+};
+inline constexpr std::size_t stageCount = 6;
+
+enum class ErrorCategory
+{
+  invalidFormat,
+  trailingCharacters,
+  divisionByZero,
+  moduloByZero,
+  unknownOperator,
+  overflow,
+  tooWide,
+};
+inline constexpr std::size_t errorCategoryCount = 7;
+
+auto categoryOf(CalcError error) -> ErrorCategory;
+
+// Bucket i counts latencies in [2^i, 2^(i+1)) nanoseconds; bucket 0 also takes 0.
+inline constexpr std::size_t latencyBuckets = 64;
+
+struct Statistics
+{
+  std::uint64_t lines{};
+  std::uint64_t renderCacheHits{};
+  std::uint64_t renderCacheMisses{};
+  std::array<std::uint64_t, errorCategoryCount> errors{};
+  std::array<std::array<std::uint64_t, latencyBuckets>, stageCount> latency{};
+};
+
+// One per thread, written only by its owner; relaxed atomics make concurrent
+// snapshots well-defined without a read-modify-write on the hot path.
+struct ThreadCounters
+{
+  std::atomic<std::uint64_t> lines{};
+  std::atomic<std::uint64_t> renderCacheHits{};
+  std::atomic<std::uint64_t> renderCacheMisses{};
+  std::array<std::atomic<std::uint64_t>, errorCategoryCount> errors{};
+  std::array<std::array<std::atomic<std::uint64_t>, latencyBuckets>, stageCount> latency{};
+};
+
+auto threadCounters() -> ThreadCounters &;
+
+// Sums the counters of all live and finished threads.
+auto collectStatistics() -> Statistics;
+auto printStatistics(Statistics const &statistics, std::ostream &out) -> void;
+
+inline auto bump(std::atomic<std::uint64_t> &counter) -> void
+{
+  counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline auto countLine() -> void
+{
+  if constexpr (statisticsEnabled)
+  {
+    bump(threadCounters().lines);
+  }
+}
+
+inline auto countRenderCache(bool hit) -> void
+{
+  if constexpr (statisticsEnabled)
+  {
+    bump(hit ? threadCounters().renderCacheHits : threadCounters().renderCacheMisses);
+  }
+}
+
+inline auto countError(ErrorCategory category) -> void
+{
+  if constexpr (statisticsEnabled)
+  {
+    bump(threadCounters().errors[static_cast<std::size_t>(category)]);
+  }
+}
+
+// Records the lifetime of the timer in the histogram of `stage`.
+class StageTimer
+{
+public:
+  explicit StageTimer(Stage stage)
+  {
+    if constexpr (statisticsEnabled)
+    {
+      this->stage = stage;
+      start = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~StageTimer()
+  {
+    if constexpr (statisticsEnabled)
+    {
+      auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      auto const nanoseconds = static_cast<std::uint64_t>(elapsed.count());
+      auto const bucket = nanoseconds == 0 ? 0 : static_cast<std::size_t>(std::bit_width(nanoseconds)) - 1;
+      bump(threadCounters().latency[static_cast<std::size_t>(stage)][bucket]);
+    }
+  }
+
+  StageTimer(StageTimer const &) = delete;
+  auto operator=(StageTimer const &) -> StageTimer & = delete;
+
+private:
+  Stage stage{};
+  std::chrono::steady_clock::time_point start{};
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "MappedFile.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+auto MappedFile::map(int fd) -> bool
+{
+  struct stat info{};
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+  {
+    return false;
+  }
+  if (info.st_size == 0)
+  {
+    return true;
+  }
+  void *mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapped == MAP_FAILED)
+  {
+    return false;
+  }
+  madvise(mapped, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+  address = mapped;
+  length = static_cast<std::size_t>(info.st_size);
+  return true;
+}
+
+auto MappedFile::contents() const -> std::string_view
+{
+  return std::string_view{static_cast<char const *>(address), length};
+}
+
+MappedFile::~MappedFile()
+{
+  if (address)
+  {
+    munmap(address, length);
+  }
+}
@@ -0,0 +1,24 @@
+#ifndef MAPPEDFILE_HPP_
+#define MAPPEDFILE_HPP_
+
+#include <cstddef>
+#include <string_view>
+
+class MappedFile
+{
+public:
+  // Maps fd read-only if it refers to a regular file, otherwise returns false.
+  auto map(int fd) -> bool;
+  auto contents() const -> std::string_view;
+
+  MappedFile() = default;
+  MappedFile(MappedFile const &) = delete;
+  auto operator=(MappedFile const &) -> MappedFile & = delete;
+  ~MappedFile();
+
+private:
+  void *address{};
+  std::size_t length{};
+};
+
+#endif
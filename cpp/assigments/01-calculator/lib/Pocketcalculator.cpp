@@ -1,64 +1,274 @@
 #include "Pocketcalculator.hpp"
 #include "Calc.hpp"
+#include "Instrumentation.hpp"
+#include "LineReader.hpp"
 #include "Sevensegment.hpp"
 
-#include <iosfwd>
-#include <sstream>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
 #include <string>
-#include <cctype>
-#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 namespace
 {
-  inline std::size_t printed_width(int value)
+  constexpr std::size_t chunkSize = 64 * 1024;
+
+  template <typename Expr, typename T>
+  auto evaluate(std::string_view line, T &result) -> CalcError
   {
-    return std::to_string(value).size();
+    Expr expr{};
+    {
+      StageTimer timer{Stage::parse};
+      if (auto const error = tryParseExpression(line, expr); error != CalcError::none)
+      {
+        return error;
+      }
+    }
+    StageTimer timer{Stage::calc};
+    return tryCalc(expr.lhs, expr.rhs, expr.op, result);
   }
-}
 
-auto pocketcalculator(std::istream &input, std::ostream &output) -> void
-{
-  std::string line;
-  while (std::getline(input, line))
+  // Evaluates and width-checks one line; on failure counts the error and returns false.
+  auto calculateLine(std::string_view line, PocketcalculatorOptions const &options, std::int64_t &result) -> bool
   {
-    if (line.empty())
+    countLine();
+
+    CalcError error{};
+    if (options.wide)
     {
-      printLargeError(output);
-      continue;
+      error = evaluate<WideExpression>(line, result);
+    }
+    else
+    {
+      int narrow{};
+      error = evaluate<Expression>(line, narrow);
+      result = narrow;
+    }
+    if (error != CalcError::none)
+    {
+      countError(categoryOf(error));
+      return false;
     }
 
-    try
+    bool tooWide{};
     {
-      std::istringstream iss(line);
-      int a{}, b{};
-      char op{};
+      StageTimer timer{Stage::widthCheck};
+      tooWide = printedWidth(result) > options.width;
+    }
+    if (tooWide)
+    {
+      countError(ErrorCategory::tooWide);
+      return false;
+    }
+    return true;
+  }
 
-      if (!(iss >> a >> op >> b))
-      {
-        throw std::invalid_argument{"invalid format"};
-      }
+  auto readLine(io::LineReader &reader, std::string_view &line) -> bool
+  {
+    StageTimer timer{Stage::read};
+    return reader.next(line);
+  }
+
+  auto pocketcalculator(io::LineReader &reader, std::ostream &output, PocketcalculatorOptions const &options) -> void
+  {
+    RenderCache cache{options.renderCache, options.width};
+    std::string_view line;
+    while (readLine(reader, line))
+    {
+      auto const block = renderCalculation(line, cache, options);
+      output.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+  }
+
+  struct Chunk
+  {
+    std::string storage{};
+    std::string_view input{};
+    std::string output{};
+    bool done{};
+  };
 
-      iss >> std::ws;
+  auto renderChunk(Chunk &chunk, RenderCache &cache, PocketcalculatorOptions const &options) -> void
+  {
+    io::LineReader reader{chunk.input};
+    std::string_view line;
+    while (reader.next(line))
+    {
+      chunk.output.append(renderCalculation(line, cache, options));
+    }
+  }
 
-      if (iss.peek() != std::char_traits<char>::eof())
+  // Workers render chunks in any order; the calling thread reads the input and
+  // writes finished chunks in input order, keeping at most `window` chunks alive.
+  auto parallelPocketcalculator(io::LineReader &reader, std::ostream &output, PocketcalculatorOptions const &options, bool stableInput) -> void
+  {
+    std::size_t const window = 4 * std::size_t{options.threads};
+    std::deque<Chunk> inFlight{};
+    std::deque<Chunk *> pending{};
+    std::mutex mutex{};
+    std::condition_variable workReady{};
+    std::condition_variable chunkDone{};
+    bool closing{};
+
+    auto const work = [&]
+    {
+      RenderCache cache{options.renderCache, options.width};
+      while (true)
       {
-        throw std::invalid_argument{"trailing characters"};
+        Chunk *chunk{};
+        {
+          std::unique_lock lock{mutex};
+          workReady.wait(lock, [&] { return closing || !pending.empty(); });
+          if (pending.empty())
+          {
+            return;
+          }
+          chunk = pending.front();
+          pending.pop_front();
+        }
+        renderChunk(*chunk, cache, options);
+        {
+          std::lock_guard lock{mutex};
+          chunk->done = true;
+        }
+        chunkDone.notify_all();
       }
+    };
 
-      const int result = calc(a, b, op);
-
-      if (printed_width(result) > 8)
+    std::vector<std::jthread> workers{};
+    auto const stopWorkers = [&]
+    {
       {
-        printLargeError(output);
+        std::lock_guard lock{mutex};
+        closing = true;
       }
-      else
+      workReady.notify_all();
+      workers.clear();
+    };
+
+    for (unsigned i = 0; i < options.threads; ++i)
+    {
+      workers.emplace_back(work);
+    }
+
+    try
+    {
+      bool more = true;
+      while (true)
       {
-        printLargeNumber(result, output);
+        while (more && inFlight.size() < window)
+        {
+          std::string_view lines;
+          bool read{};
+          {
+            StageTimer timer{Stage::read};
+            read = reader.nextLines(lines, chunkSize);
+          }
+          if (!read)
+          {
+            more = false;
+            break;
+          }
+          Chunk &chunk = inFlight.emplace_back();
+          if (stableInput)
+          {
+            chunk.input = lines;
+          }
+          else
+          {
+            chunk.storage.assign(lines);
+            chunk.input = chunk.storage;
+          }
+          {
+            std::lock_guard lock{mutex};
+            pending.push_back(&chunk);
+          }
+          workReady.notify_one();
+        }
+
+        if (inFlight.empty())
+        {
+          break;
+        }
+
+        Chunk &oldest = inFlight.front();
+        {
+          std::unique_lock lock{mutex};
+          chunkDone.wait(lock, [&] { return oldest.done; });
+        }
+        output.write(oldest.output.data(), static_cast<std::streamsize>(oldest.output.size()));
+        inFlight.pop_front();
       }
     }
     catch (...)
     {
-      printLargeError(output);
+      stopWorkers();
+      throw;
     }
+    stopWorkers();
+  }
+}
+
+auto renderCalculation(std::string_view line, char *out, PocketcalculatorOptions const &options) -> char *
+{
+  std::int64_t result{};
+  if (!calculateLine(line, options, result))
+  {
+    StageTimer timer{Stage::error};
+    return renderLargeError(out);
+  }
+  StageTimer timer{Stage::render};
+  return renderLargeNumber(result, out);
+}
+
+auto renderCalculation(std::string_view line, RenderCache &cache, PocketcalculatorOptions const &options) -> std::string_view
+{
+  std::int64_t result{};
+  if (!calculateLine(line, options, result))
+  {
+    StageTimer timer{Stage::error};
+    return RenderCache::error();
+  }
+  StageTimer timer{Stage::render};
+  auto const misses = cache.misses();
+  auto const block = cache.number(result);
+  countRenderCache(cache.misses() == misses);
+  return block;
+}
+
+auto pocketcalculator(std::istream &input, std::ostream &output) -> void
+{
+  pocketcalculator(input, output, PocketcalculatorOptions{});
+}
+
+auto pocketcalculator(std::string_view input, std::ostream &output) -> void
+{
+  pocketcalculator(input, output, PocketcalculatorOptions{});
+}
+
+auto pocketcalculator(std::istream &input, std::ostream &output, PocketcalculatorOptions const &options) -> void
+{
+  io::LineReader reader{input};
+  if (options.threads <= 1)
+  {
+    pocketcalculator(reader, output, options);
+    return;
+  }
+  parallelPocketcalculator(reader, output, options, false);
+}
+
+auto pocketcalculator(std::string_view input, std::ostream &output, PocketcalculatorOptions const &options) -> void
+{
+  io::LineReader reader{input};
+  if (options.threads <= 1)
+  {
+    pocketcalculator(reader, output, options);
+    return;
   }
+  parallelPocketcalculator(reader, output, options, true);
 }
@@ -1,8 +1,37 @@
 #ifndef POCKETCALCULATOR_HPP_
 #define POCKETCALCULATOR_HPP_
 
+#include "RenderCache.hpp"
+
+#include <cstddef>
 #include <iosfwd>
+#include <string_view>
+
+struct PocketcalculatorOptions
+{
+  // Worker threads; more than one evaluates line-aligned chunks in parallel.
+  unsigned threads{1};
+  // Results printing wider than this many characters are shown as Error.
+  std::size_t width{8};
+  // Parse and compute in overflow-checked int64_t instead of int.
+  bool wide{false};
+  // Slots of the per-thread cache of rendered results; 0 renders every line.
+  std::size_t renderCache{256};
+};
+
+// Evaluates one input line and renders its block (at most largeNumberMaxSize bytes) into `out`.
+auto renderCalculation(std::string_view line, char *out, PocketcalculatorOptions const &options) -> char *;
+
+// Same, but copies repeated results from `cache`; the block is valid until the next call.
+auto renderCalculation(std::string_view line, RenderCache &cache, PocketcalculatorOptions const &options) -> std::string_view;
 
 auto pocketcalculator(std::istream &input, std::ostream &output) -> void;
 
-#endif
\ No newline at end of file
+// Same as above, for input that is already in memory (e.g. a mapped file).
+auto pocketcalculator(std::string_view input, std::ostream &output) -> void;
+
+// With threads > 1, output order still matches input order.
+auto pocketcalculator(std::istream &input, std::ostream &output, PocketcalculatorOptions const &options) -> void;
+auto pocketcalculator(std::string_view input, std::ostream &output, PocketcalculatorOptions const &options) -> void;
+
+#endif
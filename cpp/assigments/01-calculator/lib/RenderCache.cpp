@@ -0,0 +1,47 @@
+#include "RenderCache.hpp"
+
+#include <algorithm>
+#include <bit>
+
+RenderCache::RenderCache(std::size_t capacity, std::size_t maxWidth)
+    : stride{largeBlockSize(std::min<std::size_t>(maxWidth, 20))},
+      slots(capacity == 0 ? 0 : std::bit_ceil(std::min(capacity, maxCapacity))),
+      blocks(slots.size() * stride)
+{
+}
+
+auto RenderCache::number(std::int64_t value) -> std::string_view
+{
+  if (!slots.empty())
+  {
+    auto const index = static_cast<std::size_t>(static_cast<std::uint64_t>(value) & (slots.size() - 1));
+    Slot &slot = slots[index];
+    char *const block = blocks.data() + index * stride;
+    if (slot.length != 0 && slot.key == value)
+    {
+      ++hitCount;
+      return {block, slot.length};
+    }
+
+    ++missCount;
+    if (largeBlockSize(printedWidth(value)) <= stride)
+    {
+      slot.key = value;
+      slot.length = static_cast<std::size_t>(renderLargeNumber(value, block) - block);
+      return {block, slot.length};
+    }
+  }
+  else
+  {
+    ++missCount;
+  }
+
+  char const *const end = renderLargeNumber(value, scratch.data());
+  return {scratch.data(), static_cast<std::size_t>(end - scratch.data())};
+}
+
+auto RenderCache::hitRate() const -> double
+{
+  auto const lookups = hitCount + missCount;
+  return lookups == 0 ? 0.0 : static_cast<double>(hitCount) / static_cast<double>(lookups);
+}
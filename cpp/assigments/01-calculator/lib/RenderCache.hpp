@@ -0,0 +1,57 @@
+#ifndef RENDERCACHE_HPP_
+#define RENDERCACHE_HPP_
+
+#include "Sevensegment.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Rendered seven-segment blocks of recent results, so frequent values (0, 1,
+// small totals) are copied instead of rebuilt. Direct-mapped: a result has one
+// slot, chosen by its low bits, and replaces whatever was there. Not thread-safe;
+// use one cache per thread.
+class RenderCache
+{
+public:
+  // Largest number of slots; about 5 MB of blocks for 20-character results.
+  static constexpr std::size_t maxCapacity = std::size_t{1} << 14;
+
+  // Holds `capacity` slots (rounded up to a power of two and clamped to
+  // maxCapacity; 0 disables caching) for results at most `maxWidth` characters
+  // wide. Wider results are rendered on every call.
+  explicit RenderCache(std::size_t capacity, std::size_t maxWidth = 20);
+
+  // The block of `value`, valid until the next call to number().
+  auto number(std::int64_t value) -> std::string_view;
+
+  // The Error block of printLargeError(), prebuilt at compile time.
+  static auto error() -> std::string_view
+  {
+    return {detail::errorBlock.data(), detail::errorBlock.size()};
+  }
+
+  auto hits() const -> std::size_t { return hitCount; }
+  auto misses() const -> std::size_t { return missCount; }
+  auto hitRate() const -> double;
+  auto capacity() const -> std::size_t { return slots.size(); }
+
+private:
+  struct Slot
+  {
+    std::int64_t key{};
+    // Bytes of the block in `blocks`; 0 marks an empty slot.
+    std::size_t length{};
+  };
+
+  std::size_t stride;
+  std::vector<Slot> slots;
+  std::vector<char> blocks;
+  std::array<char, largeNumberMaxSize> scratch{};
+  std::size_t hitCount{};
+  std::size_t missCount{};
+};
+
+#endif
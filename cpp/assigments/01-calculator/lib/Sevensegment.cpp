@@ -3,67 +3,6 @@
 #include <array>
 #include <ostream>
 #include <stdexcept>
-#include <string>
-#include <vector>
-
-std::array<std::string, 5> const minus{"   ", "   ", " - ", "   ", "   "};
-std::array<std::array<std::string, 5>, 10> const digits{
-    {
-        {" - ",
-         "| |",
-         "   ",
-         "| |",
-         " - "},
-        {"   ",
-         "  |",
-         "   ",
-         "  |",
-         "   "},
-        {" - ",
-         "  |",
-         " - ",
-         "|  ",
-         " - "},
-        {" - ",
-         "  |",
-         " - ",
-         "  |",
-         " - "},
-        {"   ",
-         "| |",
-         " - ",
-         "  |",
-         "   "},
-        {" - ",
-         "|  ",
-         " - ",
-         "  |",
-         " - "},
-        {" - ",
-         "|  ",
-         " - ",
-         "| |",
-         " - "},
-        {" - ",
-         "  |",
-         "   ",
-         "  |",
-         "   "},
-        {" - ",
-         "| |",
-         " - ",
-         "| |",
-         " - "},
-        {" - ",
-         "| |",
-         " - ",
-         "  |",
-         " - "},
-    }};
-
-static const std::array<std::string, 5> glyph_E{" - ", "|  ", " - ", "|  ", " - "};
-static const std::array<std::string, 5> glyph_r{"   ", "   ", " - ", "|  ", "   "};
-static const std::array<std::string, 5> glyph_o{"   ", "   ", " - ", "| |", " - "};
 
 auto printLargeDigit(int digit, std::ostream &output) -> void
 {
@@ -72,45 +11,20 @@ auto printLargeDigit(int digit, std::ostream &output) -> void
         throw std::invalid_argument("printLargeDigit expects 0..9");
     }
 
-    for (const auto &line : digits[static_cast<std::size_t>(digit)])
-    {
-        output << line << '\n';
-    }
+    std::array<char, largeBlockSize(1)> block;
+    detail::Glyph const *glyph = &detail::digits[static_cast<std::size_t>(digit)];
+    detail::renderGlyphs(&glyph, 1, block.data());
+    output.write(block.data(), static_cast<std::streamsize>(block.size()));
 }
 
-inline const std::array<std::string, 5> &glyphFor(char c)
+auto printLargeNumber(std::int64_t i, std::ostream &output) -> void
 {
-    if (c == '-')
-        return minus;
-    return digits[static_cast<std::size_t>(c - '0')];
-}
-
-auto printLargeNumber(int i, std::ostream &output) -> void
-{
-    const std::string text = std::to_string(i);
-
-    for (int row = 0; row < 5; ++row)
-    {
-        for (std::size_t col = 0; col < text.size(); ++col)
-        {
-            const auto &glyph = glyphFor(text[col]);
-            output << glyph[static_cast<std::size_t>(row)];
-        }
-        output << '\n';
-    }
+    std::array<char, largeNumberMaxSize> block;
+    char const *const end = renderLargeNumber(i, block.data());
+    output.write(block.data(), end - block.data());
 }
 
 auto printLargeError(std::ostream &out) -> void
 {
-    const std::array<const std::array<std::string, 5> *, 5> word{
-        &glyph_E, &glyph_r, &glyph_r, &glyph_o, &glyph_r};
-
-    for (int row = 0; row < 5; ++row)
-    {
-        for (std::size_t i = 0; i < word.size(); ++i)
-        {
-            out << (*word[i])[static_cast<std::size_t>(row)];
-        }
-        out << '\n';
-    }
-}
\ No newline at end of file
+    out.write(detail::errorBlock.data(), static_cast<std::streamsize>(detail::errorBlock.size()));
+}
@@ -1,12 +1,178 @@
 #ifndef SEVENSEGMENT_HPP_
 #define SEVENSEGMENT_HPP_
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 
+constexpr std::size_t largeGlyphRows = 5;
+constexpr std::size_t largeGlyphWidth = 3;
+
+// Bytes needed to render `glyphs` characters, including the row terminators.
+constexpr auto largeBlockSize(std::size_t glyphs) -> std::size_t
+{
+    return largeGlyphRows * (glyphs * largeGlyphWidth + 1);
+}
+
+// Number of decimal digits, via the bit width and one power-of-ten lookup.
+constexpr auto digitCount(std::uint64_t value) -> std::size_t
+{
+    constexpr auto powers = []
+    {
+        std::array<std::uint64_t, 20> table{};
+        std::uint64_t power = 1;
+        for (auto &entry : table)
+        {
+            entry = power;
+            power *= 10;
+        }
+        return table;
+    }();
+    value |= 1;
+    std::size_t const guess = (static_cast<std::size_t>(std::bit_width(value)) * 1233) >> 12;
+    return guess + (value >= powers[guess] ? 1 : 0);
+}
+
+// Characters needed to print `value`, including the sign.
+constexpr auto printedWidth(std::int64_t value) -> std::size_t
+{
+    auto const magnitude = value < 0 ? std::uint64_t{0} - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+    return digitCount(magnitude) + (value < 0 ? 1 : 0);
+}
+
+// Enough for any int64_t, i.e. "-9223372036854775808".
+constexpr std::size_t largeNumberMaxSize = largeBlockSize(20);
+
+namespace detail
+{
+    struct Glyph
+    {
+        char rows[largeGlyphRows][largeGlyphWidth + 1];
+    };
+
+    inline constexpr Glyph minus{"   ", "   ", " - ", "   ", "   "};
+    inline constexpr std::array<Glyph, 10> digits{
+        {
+            {" - ",
+             "| |",
+             "   ",
+             "| |",
+             " - "},
+            {"   ",
+             "  |",
+             "   ",
+             "  |",
+             "   "},
+            {" - ",
+             "  |",
+             " - ",
+             "|  ",
+             " - "},
+            {" - ",
+             "  |",
+             " - ",
+             "  |",
+             " - "},
+            {"   ",
+             "| |",
+             " - ",
+             "  |",
+             "   "},
+            {" - ",
+             "|  ",
+             " - ",
+             "  |",
+             " - "},
+            {" - ",
+             "|  ",
+             " - ",
+             "| |",
+             " - "},
+            {" - ",
+             "  |",
+             "   ",
+             "  |",
+             "   "},
+            {" - ",
+             "| |",
+             " - ",
+             "| |",
+             " - "},
+            {" - ",
+             "| |",
+             " - ",
+             "  |",
+             " - "},
+        }};
+
+    inline constexpr Glyph glyph_E{" - ", "|  ", " - ", "|  ", " - "};
+    inline constexpr Glyph glyph_r{"   ", "   ", " - ", "|  ", "   "};
+    inline constexpr Glyph glyph_o{"   ", "   ", " - ", "| |", " - "};
+
+    constexpr auto renderGlyphs(Glyph const *const *glyphs, std::size_t count, char *out) -> char *
+    {
+        for (std::size_t row = 0; row < largeGlyphRows; ++row)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                out = std::copy_n(glyphs[i]->rows[row], largeGlyphWidth, out);
+            }
+            *out++ = '\n';
+        }
+        return out;
+    }
+
+    inline constexpr std::array<Glyph const *, 5> errorWord{&glyph_E, &glyph_r, &glyph_r, &glyph_o, &glyph_r};
+
+    inline constexpr auto errorBlock = []
+    {
+        std::array<char, largeBlockSize(errorWord.size())> block{};
+        renderGlyphs(errorWord.data(), errorWord.size(), block.data());
+        return block;
+    }();
+}
+
+// Render the complete block into `out` and return one past the last written byte.
+constexpr auto renderLargeNumber(std::int64_t number, char *out) -> char *
+{
+    auto const width = printedWidth(number);
+    auto magnitude = number < 0 ? std::uint64_t{0} - static_cast<std::uint64_t>(number) : static_cast<std::uint64_t>(number);
+
+    std::array<detail::Glyph const *, 20> glyphs{};
+    std::size_t i = width;
+    do
+    {
+        glyphs[--i] = &detail::digits[magnitude % 10];
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (number < 0)
+    {
+        glyphs[0] = &detail::minus;
+    }
+    return detail::renderGlyphs(glyphs.data(), width, out);
+}
+
+constexpr auto renderLargeError(char *out) -> char *
+{
+    return std::copy(detail::errorBlock.begin(), detail::errorBlock.end(), out);
+}
+
+// The block for a number known at compile time, sized exactly, e.g. for static displays.
+template <std::int64_t Number>
+constexpr auto largeNumberBlock() -> std::array<char, largeBlockSize(printedWidth(Number))>
+{
+    std::array<char, largeBlockSize(printedWidth(Number))> block{};
+    renderLargeNumber(Number, block.data());
+    return block;
+}
+
 auto printLargeDigit(int digit, std::ostream &out) -> void;
 
-auto printLargeNumber(int number, std::ostream &out) -> void;
+auto printLargeNumber(std::int64_t number, std::ostream &out) -> void;
 
 auto printLargeError(std::ostream &out) -> void;
 
-#endif
\ No newline at end of file
+#endif
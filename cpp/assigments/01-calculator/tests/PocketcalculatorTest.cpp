@@ -1,10 +1,30 @@
+#include "BatchCalc.hpp"
+#include "Calc.hpp"
+#include "CalculatorServer.hpp"
+#include "ExpressionEngine.hpp"
+#include "Instrumentation.hpp"
+#include "LineReader.hpp"
 #include "Pocketcalculator.hpp"
+#include "RenderCache.hpp"
 #include "Sevensegment.hpp"
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
-static std::string renderNumber(int v)
+#include <unistd.h>
+
+static std::string renderNumber(std::int64_t v)
 {
   std::ostringstream os;
   printLargeNumber(v, os);
@@ -140,4 +160,547 @@ TEST_CASE("bad line then good line")
   std::ostringstream output{};
   pocketcalculator(input, output);
   REQUIRE(output.str() == renderError() + renderNumber(9));
-}
\ No newline at end of file
+}
+TEST_CASE("parseExpression accepts and rejects like calc(std::istream&)")
+{
+  std::vector<std::string> const lines{
+      "6*7", "  6  *  7  ", "+6*-7", "-6--7", "6*+7", "6*+-7", "+ 6*7", "- 6*7",
+      "6*", "*7", "6", "", " ", "\t1\v+\f2\r", "1+2 x", "1.5+2", "12 34 5",
+      "2147483647+0", "-2147483648+0", "2147483648+0", "99999999999+1", "1+-",
+      "007+0x10", "1$2", "1/0", "5%0", "a+b", "1e3+1"};
+
+  for (auto const &line : lines)
+  {
+    CAPTURE(line);
+    std::istringstream in{line};
+    bool streamAccepted = true;
+    int streamResult{};
+    try
+    {
+      streamResult = calc(in);
+    }
+    catch (std::invalid_argument const &)
+    {
+      streamAccepted = false;
+    }
+
+    bool parserAccepted = true;
+    int parserResult{};
+    try
+    {
+      auto const [a, op, b] = parseExpression(line);
+      parserResult = calc(a, b, op);
+    }
+    catch (std::invalid_argument const &)
+    {
+      parserAccepted = false;
+    }
+
+    REQUIRE(parserAccepted == streamAccepted);
+    REQUIRE(parserResult == streamResult);
+  }
+}
+
+TEST_CASE("LineReader splits lines across block boundaries")
+{
+  std::istringstream input{"1+1\nlonger line than block\n\nlast"};
+  io::LineReader reader{input, 4};
+  std::vector<std::string> lines{};
+  std::string_view line;
+  while (reader.next(line))
+  {
+    lines.emplace_back(line);
+  }
+  REQUIRE(lines == std::vector<std::string>{"1+1", "longer line than block", "", "last"});
+}
+
+TEST_CASE("in-memory input gives the same output as a stream")
+{
+  std::string const text{"1+1\n\nnope\n2*3"};
+  std::istringstream input{text};
+  std::ostringstream streamed{};
+  std::ostringstream mapped{};
+  pocketcalculator(input, streamed);
+  pocketcalculator(std::string_view{text}, mapped);
+  REQUIRE(mapped.str() == streamed.str());
+  REQUIRE(mapped.str() == renderNumber(2) + renderError() + renderError() + renderNumber(6));
+}
+
+TEST_CASE("printLargeNumber renders the seven-segment block")
+{
+  REQUIRE(renderNumber(-10) ==
+          "       - \n"
+          "     || |\n"
+          " -       \n"
+          "     || |\n"
+          "       - \n");
+}
+
+TEST_CASE("printLargeError renders the Error block")
+{
+  REQUIRE(renderError() ==
+          " -             \n"
+          "|              \n"
+          " -  -  -  -  - \n"
+          "|  |  |  | ||  \n"
+          " -        -    \n");
+}
+
+TEST_CASE("renderLargeNumber fills the caller buffer with the whole block")
+{
+  char block[largeNumberMaxSize];
+  char *end = renderLargeNumber(std::numeric_limits<std::int64_t>::min(), block);
+  REQUIRE(static_cast<std::size_t>(end - block) == largeNumberMaxSize);
+  REQUIRE(std::string(block, end) == renderNumber(std::numeric_limits<std::int64_t>::min()));
+
+  end = renderLargeError(block);
+  REQUIRE(std::string(block, end) == renderError());
+}
+
+TEST_CASE("parallel mode preserves input order")
+{
+  std::string text{};
+  for (int i = 0; i < 30000; ++i)
+  {
+    text += std::to_string(i) + (i % 7 == 0 ? "/0\n" : "*3\n");
+  }
+  text += "1+1";
+
+  std::ostringstream sequential{};
+  std::istringstream sequentialInput{text};
+  pocketcalculator(sequentialInput, sequential);
+
+  std::ostringstream streamed{};
+  std::istringstream parallelInput{text};
+  pocketcalculator(parallelInput, streamed, PocketcalculatorOptions{.threads = 4});
+  REQUIRE(streamed.str() == sequential.str());
+
+  std::ostringstream mapped{};
+  pocketcalculator(std::string_view{text}, mapped, PocketcalculatorOptions{.threads = 3});
+  REQUIRE(mapped.str() == sequential.str());
+}
+
+TEST_CASE("tryCalc reports every failure as an error code")
+{
+  int result{};
+  REQUIRE(tryCalc(6, 7, '*', result) == CalcError::none);
+  REQUIRE(result == 42);
+  REQUIRE(tryCalc(1, 0, '/', result) == CalcError::divisionByZero);
+  REQUIRE(tryCalc(5, 0, '%', result) == CalcError::moduloByZero);
+  REQUIRE(tryCalc(1, 2, '$', result) == CalcError::unknownOperator);
+  REQUIRE(result == 42);
+}
+
+TEST_CASE("tryParseExpression distinguishes format and trailing errors")
+{
+  Expression expr{};
+  REQUIRE(tryParseExpression(" 6 * -7 ", expr) == CalcError::none);
+  REQUIRE(expr.lhs == 6);
+  REQUIRE(expr.op == '*');
+  REQUIRE(expr.rhs == -7);
+  REQUIRE(tryParseExpression("foo bar", expr) == CalcError::invalidFormat);
+  REQUIRE(tryParseExpression("", expr) == CalcError::invalidFormat);
+  REQUIRE(tryParseExpression("1+2 x", expr) == CalcError::trailingCharacters);
+}
+
+TEST_CASE("throwing wrappers keep their messages")
+{
+  REQUIRE_THROWS_WITH(calc(1, 0, '/'), "Error: Division duch 0");
+  REQUIRE_THROWS_WITH(calc(5, 0, '%'), "Error: Modulo mit 0, wa willsch?");
+  REQUIRE_THROWS_WITH(calc(1, 2, '$'), "unknown operator");
+  REQUIRE_THROWS_WITH(parseExpression("1+2 x"), "trailing characters");
+}
+
+TEST_CASE("expression engine honours precedence and parentheses")
+{
+  int result{};
+  REQUIRE(evaluateExpression("3 + 4 * (2 - 1)", result) == CalcError::none);
+  REQUIRE(result == 7);
+  REQUIRE(evaluateExpression("(3 + 4) * 2 - 1", result) == CalcError::none);
+  REQUIRE(result == 13);
+  REQUIRE(evaluateExpression("20 / 3 % 4", result) == CalcError::none);
+  REQUIRE(result == 2);
+  REQUIRE(evaluateExpression("-(2 - 5) * -2", result) == CalcError::none);
+  REQUIRE(result == -6);
+  REQUIRE(evaluateExpression("-2147483648 + 0", result) == CalcError::none);
+  REQUIRE(result == -2147483647 - 1);
+}
+
+TEST_CASE("expression engine accepts every single-operator line calc accepts")
+{
+  for (auto const *line : {"6*7", "  6  *  7  ", "+6*-7", "-6--7", "6*+7", "1/2", "-7%3"})
+  {
+    CAPTURE(line);
+    int result{};
+    REQUIRE(evaluateExpression(line, result) == CalcError::none);
+    auto const [a, op, b] = parseExpression(line);
+    REQUIRE(result == calc(a, b, op));
+  }
+}
+
+TEST_CASE("expression engine reports calc errors")
+{
+  int result{};
+  REQUIRE(evaluateExpression("1 / (2 - 2)", result) == CalcError::divisionByZero);
+  REQUIRE(evaluateExpression("1 % 0", result) == CalcError::moduloByZero);
+  REQUIRE(evaluateExpression("(1 + 2", result) == CalcError::invalidFormat);
+  REQUIRE(evaluateExpression("1 +", result) == CalcError::invalidFormat);
+  REQUIRE(evaluateExpression("", result) == CalcError::invalidFormat);
+  REQUIRE(evaluateExpression("1 2", result) == CalcError::trailingCharacters);
+  REQUIRE(evaluateExpression("1 $ 2", result) == CalcError::trailingCharacters);
+  REQUIRE(evaluateExpression(std::string(1000, '(') + "1" + std::string(1000, ')'), result) == CalcError::invalidFormat);
+}
+
+TEST_CASE("expression cache reuses programs for normalized text")
+{
+  ExpressionCache cache{2};
+  int result{};
+  REQUIRE(cache.evaluate("1 + 2", result) == CalcError::none);
+  REQUIRE(result == 3);
+  REQUIRE(cache.evaluate("  1 \t+   2 ", result) == CalcError::none);
+  REQUIRE(cache.hits() == 1);
+  REQUIRE(cache.misses() == 1);
+
+  REQUIRE(cache.evaluate("1 / 0", result) == CalcError::divisionByZero);
+  REQUIRE(cache.evaluate("4 * 4", result) == CalcError::none);
+  REQUIRE(result == 16);
+  REQUIRE(cache.size() == 2);
+
+  REQUIRE(cache.evaluate("1 + 2", result) == CalcError::none);
+  REQUIRE(result == 3);
+  REQUIRE(cache.hits() == 1);
+  REQUIRE(cache.misses() == 4);
+  REQUIRE(cache.hitRate() == 0.2);
+}
+
+TEST_CASE("int arithmetic reports overflow instead of wrapping")
+{
+  int result{};
+  REQUIRE(tryCalc(65536, 65536, '*', result) == CalcError::overflow);
+  REQUIRE(tryCalc(std::numeric_limits<int>::max(), 1, '+', result) == CalcError::overflow);
+  REQUIRE(tryCalc(std::numeric_limits<int>::min(), 1, '-', result) == CalcError::overflow);
+  REQUIRE(tryCalc(std::numeric_limits<int>::min(), -1, '/', result) == CalcError::overflow);
+  REQUIRE(tryCalc(std::numeric_limits<int>::min(), -1, '%', result) == CalcError::none);
+  REQUIRE(result == 0);
+  REQUIRE_THROWS_WITH(calc(65536, 65536, '*'), "overflow");
+}
+
+TEST_CASE("64-bit arithmetic is overflow-checked")
+{
+  std::int64_t result{};
+  REQUIRE(tryCalc(std::int64_t{65536}, std::int64_t{65536}, '*', result) == CalcError::none);
+  REQUIRE(result == 4294967296);
+  REQUIRE(tryCalc(std::numeric_limits<std::int64_t>::max(), std::int64_t{1}, '+', result) == CalcError::overflow);
+
+  WideExpression expr{};
+  REQUIRE(tryParseExpression("9223372036854775807 - 1", expr) == CalcError::none);
+  REQUIRE(expr.lhs == std::numeric_limits<std::int64_t>::max());
+  REQUIRE(tryParseExpression("9223372036854775808 - 1", expr) == CalcError::invalidFormat);
+}
+
+TEST_CASE("printedWidth counts digits and sign without formatting")
+{
+  for (std::int64_t v : {std::int64_t{0}, std::int64_t{9}, std::int64_t{10}, std::int64_t{-1}, std::int64_t{99999999},
+                         std::int64_t{100000000}, std::int64_t{-1234567}, std::numeric_limits<std::int64_t>::max(),
+                         std::numeric_limits<std::int64_t>::min()})
+  {
+    CAPTURE(v);
+    REQUIRE(printedWidth(v) == std::to_string(v).size());
+  }
+  std::uint64_t power = 1;
+  for (std::size_t digits = 1; digits < 20; ++digits, power *= 10)
+  {
+    REQUIRE(digitCount(power - 1) == (digits == 1 ? 1 : digits - 1));
+    REQUIRE(digitCount(power) == digits);
+  }
+  REQUIRE(digitCount(std::numeric_limits<std::uint64_t>::max()) == 20);
+}
+
+TEST_CASE("overflowing product is an Error, not a wrapped value")
+{
+  std::istringstream input{"65536*65536\n"};
+  std::ostringstream output{};
+  pocketcalculator(input, output);
+  REQUIRE(output.str() == renderError());
+}
+
+TEST_CASE("wide mode renders results beyond 32 bits up to the configured width")
+{
+  std::istringstream input{"65536*65536\n9223372036854775807+1\n4294967296*10\n"};
+  std::ostringstream output{};
+  pocketcalculator(input, output, PocketcalculatorOptions{.width = 10, .wide = true});
+  REQUIRE(output.str() == renderNumber(4294967296) + renderError() + renderError());
+}
+
+TEST_CASE("display width is configurable")
+{
+  std::istringstream input{"100*10\n99*10\n"};
+  std::ostringstream output{};
+  pocketcalculator(input, output, PocketcalculatorOptions{.width = 3});
+  REQUIRE(output.str() == renderError() + renderNumber(990));
+}
+
+TEST_CASE("server sessions answer like pocketcalculator()")
+{
+  auto const socketPath = (std::filesystem::temp_directory_path() /
+                           ("pocketcalculator-test-" + std::to_string(getpid()) + ".sock"))
+                              .string();
+  CalculatorServer server{socketPath, PocketcalculatorOptions{}};
+  std::jthread loop{[&] { server.run(); }};
+
+  std::vector<std::string> inputs{"", "6*7\n", "1+1\nnope\n2*3", "5%0\n\n-4-4\n"};
+  std::string large{};
+  for (int i = 0; i < 20000; ++i)
+  {
+    large += std::to_string(i) + "*3\n";
+  }
+  inputs.push_back(large);
+
+  std::vector<std::string> answers(inputs.size());
+  {
+    std::vector<std::jthread> clients{};
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+      clients.emplace_back([&, i] { answers[i] = calculateRemote(socketPath, inputs[i]); });
+    }
+  }
+  server.stop();
+
+  for (std::size_t i = 0; i < inputs.size(); ++i)
+  {
+    std::istringstream input{inputs[i]};
+    std::ostringstream expected{};
+    pocketcalculator(input, expected);
+    REQUIRE(answers[i] == expected.str());
+  }
+}
+
+TEST_CASE("server answers an overlong line with Error and closes the session")
+{
+  auto const socketPath = (std::filesystem::temp_directory_path() /
+                           ("pocketcalculator-overlong-" + std::to_string(getpid()) + ".sock"))
+                              .string();
+  CalculatorServer server{socketPath, PocketcalculatorOptions{}};
+  std::jthread loop{[&] { server.run(); }};
+
+  auto const answer = calculateRemote(socketPath, "6*7\n" + std::string(4 * 1024 * 1024, '1'));
+  auto const next = calculateRemote(socketPath, "2*3\n");
+  server.stop();
+
+  REQUIRE(answer == renderNumber(42) + renderError());
+  REQUIRE(next == renderNumber(6));
+}
+
+TEST_CASE("instrumentation counts lines and error categories")
+{
+  auto const before = collectStatistics();
+  std::istringstream input{"6*7\nfoo\n1+2 x\n1/0\n5%0\n1$2\n65536*65536\n123456789+0\n\n"};
+  std::ostringstream output{};
+  pocketcalculator(input, output);
+  auto const after = collectStatistics();
+
+  auto const errors = [&](ErrorCategory category)
+  {
+    auto const i = static_cast<std::size_t>(category);
+    return after.errors[i] - before.errors[i];
+  };
+  std::uint64_t const expected = statisticsEnabled ? 1 : 0;
+  REQUIRE(after.lines - before.lines == 9 * expected);
+  REQUIRE(errors(ErrorCategory::invalidFormat) == 2 * expected);
+  REQUIRE(errors(ErrorCategory::trailingCharacters) == expected);
+  REQUIRE(errors(ErrorCategory::divisionByZero) == expected);
+  REQUIRE(errors(ErrorCategory::moduloByZero) == expected);
+  REQUIRE(errors(ErrorCategory::unknownOperator) == expected);
+  REQUIRE(errors(ErrorCategory::overflow) == expected);
+  REQUIRE(errors(ErrorCategory::tooWide) == expected);
+
+  std::uint64_t renders{};
+  for (auto const count : after.latency[static_cast<std::size_t>(Stage::render)])
+  {
+    renders += count;
+  }
+  for (auto const count : before.latency[static_cast<std::size_t>(Stage::render)])
+  {
+    renders -= count;
+  }
+  REQUIRE(renders == expected);
+  REQUIRE(after.renderCacheHits + after.renderCacheMisses - before.renderCacheHits - before.renderCacheMisses == expected);
+}
+
+namespace
+{
+  template <std::size_t N>
+  constexpr auto blockText(std::array<char, N> const &block) -> std::string_view
+  {
+    return std::string_view{block.data(), block.size()};
+  }
+
+  template <char Op>
+  constexpr auto errorOf(int x, int y) -> CalcError
+  {
+    int result{};
+    return tryCalc<Op>(x, y, result);
+  }
+}
+
+static_assert(calc<'+'>(2, 3) == 5);
+static_assert(calc<'-'>(2, 3) == -1);
+static_assert(calc<'*'>(std::int64_t{65536}, std::int64_t{65536}) == 4294967296);
+static_assert(calc<'/'>(7, 2) == 3);
+static_assert(calc<'%'>(7, 2) == 1);
+static_assert(calc(6, 7, '*') == 42);
+static_assert(errorOf<'/'>(1, 0) == CalcError::divisionByZero);
+static_assert(errorOf<'%'>(1, 0) == CalcError::moduloByZero);
+static_assert(errorOf<'+'>(std::numeric_limits<int>::max(), 1) == CalcError::overflow);
+static_assert(visitOperation('$', [](auto) { return CalcError::none; }) == CalcError::unknownOperator);
+
+static_assert(largeNumberBlock<-10>().size() == largeBlockSize(3));
+static_assert(blockText(largeNumberBlock<-10>()) ==
+              "       - \n"
+              "     || |\n"
+              " -       \n"
+              "     || |\n"
+              "       - \n");
+
+TEST_CASE("compile-time blocks match the runtime renderer")
+{
+  constexpr auto block = largeNumberBlock<1234567890123>();
+  REQUIRE(std::string{blockText(block)} == renderNumber(1234567890123));
+
+  constexpr auto error = [] {
+    std::array<char, largeBlockSize(5)> block{};
+    renderLargeError(block.data());
+    return block;
+  }();
+  REQUIRE(std::string{blockText(error)} == renderError());
+}
+
+TEST_CASE("batch kernels agree with scalar calc")
+{
+  constexpr int min = std::numeric_limits<int>::min();
+  constexpr int max = std::numeric_limits<int>::max();
+  std::vector<int> const edges{0, 1, -1, 2, -2, 7, -7, 65536, -65536, 46341, -46341, max, min, max - 1, min + 1};
+  std::vector<int> lhs{};
+  std::vector<int> rhs{};
+  for (int x : edges)
+  {
+    for (int y : edges)
+    {
+      lhs.push_back(x);
+      rhs.push_back(y);
+    }
+  }
+  std::mt19937 random{7};
+  std::uniform_int_distribution<int> any{min, max};
+  std::uniform_int_distribution<int> small{-1000, 1000};
+  for (int i = 0; i < 1001; ++i)
+  {
+    lhs.push_back(i % 2 ? any(random) : small(random));
+    rhs.push_back(i % 3 ? small(random) : any(random));
+  }
+
+  for (auto kernel = BatchKernel::scalar; kernel <= supportedBatchKernel();
+       kernel = static_cast<BatchKernel>(static_cast<int>(kernel) + 1))
+  {
+    for (char op : {'+', '-', '*', '/', '%'})
+    {
+      std::vector<int> results(lhs.size(), 4711);
+      std::vector<CalcError> errors(lhs.size());
+      auto const failed = calcBatch(lhs, rhs, op, results, errors, kernel);
+
+      std::size_t expectedFailed{};
+      for (std::size_t i = 0; i < lhs.size(); ++i)
+      {
+        int expected{4711};
+        auto const error = tryCalc(lhs[i], rhs[i], op, expected);
+        expectedFailed += error != CalcError::none;
+        INFO(lhs[i] << ' ' << op << ' ' << rhs[i] << ", kernel " << static_cast<int>(kernel));
+        REQUIRE(errors[i] == error);
+        REQUIRE(results[i] == expected);
+      }
+      REQUIRE(failed == expectedFailed);
+    }
+  }
+}
+
+TEST_CASE("batch with an operator per element")
+{
+  std::vector<int> const lhs{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  std::vector<int> const rhs{1, 0, 3, 0, 5, 2, 7, 8, 9, 3};
+  std::vector<char> const ops{'+', '/', '*', '%', '-', '-', '$', '*', '*', '%'};
+  std::vector<int> results(lhs.size());
+  std::vector<CalcError> errors(lhs.size());
+
+  REQUIRE(calcBatch(lhs, rhs, ops, results, errors) == 3);
+  REQUIRE(results == std::vector<int>{2, 0, 9, 0, 0, 4, 0, 64, 81, 1});
+  REQUIRE(errors[1] == CalcError::divisionByZero);
+  REQUIRE(errors[3] == CalcError::moduloByZero);
+  REQUIRE(errors[6] == CalcError::unknownOperator);
+
+  std::vector<int> const many(100, 12);
+  std::vector<int> const divisors(100, 5);
+  std::vector<char> grouped(100, '*');
+  std::fill(grouped.begin() + 50, grouped.end(), '%');
+  results.resize(100);
+  errors.resize(100);
+  REQUIRE(calcBatch(many, divisors, grouped, results, errors) == 0);
+  REQUIRE(results[49] == 60);
+  REQUIRE(results[50] == 2);
+
+  std::vector<int> shorter(lhs.size() - 1);
+  REQUIRE_THROWS_AS(calcBatch(lhs, rhs, '+', shorter, errors), std::invalid_argument);
+}
+
+TEST_CASE("render cache returns the blocks of the renderer")
+{
+  RenderCache cache{4};
+  REQUIRE(cache.capacity() == 4);
+  REQUIRE(std::string{cache.number(0)} == renderNumber(0));
+  REQUIRE(std::string{cache.number(0)} == renderNumber(0));
+  REQUIRE(std::string{cache.number(-3)} == renderNumber(-3));
+  REQUIRE(cache.hits() == 1);
+  REQUIRE(cache.misses() == 2);
+
+  // 4 shares the slot of 0 and evicts it.
+  REQUIRE(std::string{cache.number(4)} == renderNumber(4));
+  REQUIRE(std::string{cache.number(0)} == renderNumber(0));
+  REQUIRE(cache.misses() == 4);
+
+  REQUIRE(std::string{RenderCache::error()} == renderError());
+
+  RenderCache narrow{8, 2};
+  REQUIRE(std::string{narrow.number(123)} == renderNumber(123));
+  REQUIRE(std::string{narrow.number(123)} == renderNumber(123));
+  REQUIRE(narrow.hits() == 0);
+
+  RenderCache huge{std::numeric_limits<std::size_t>::max()};
+  REQUIRE(huge.capacity() == RenderCache::maxCapacity);
+  REQUIRE(std::string{huge.number(7)} == renderNumber(7));
+
+  RenderCache disabled{0};
+  REQUIRE(std::string{disabled.number(std::numeric_limits<std::int64_t>::min())} == renderNumber(std::numeric_limits<std::int64_t>::min()));
+  REQUIRE(disabled.misses() == 1);
+}
+
+TEST_CASE("pocketcalculator output does not depend on the render cache")
+{
+  std::string input{};
+  for (int i = 0; i < 2000; ++i)
+  {
+    input += std::to_string(i % 37) + " * " + std::to_string(i % 5 - 2) + (i % 11 == 0 ? " / 0\n" : "\n");
+  }
+
+  PocketcalculatorOptions cached{};
+  PocketcalculatorOptions uncached{};
+  uncached.renderCache = 0;
+  std::ostringstream withCache{};
+  std::ostringstream withoutCache{};
+  pocketcalculator(std::string_view{input}, withCache, cached);
+  pocketcalculator(std::string_view{input}, withoutCache, uncached);
+  REQUIRE(withCache.str() == withoutCache.str());
+
+  cached.threads = 3;
+  std::ostringstream parallel{};
+  pocketcalculator(std::string_view{input}, parallel, cached);
+  REQUIRE(parallel.str() == withoutCache.str());
+}
@@ -1,15 +1,182 @@
-#include "kwic.hpp"
-#include "word.hpp"
+#include "IndexFile.hpp"
+#include "Kwic.hpp"
+#include "KwicIndex.hpp"
+#include "Word.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+    template <typename T>
+    bool parseNumber(std::string_view text, T &value)
+    {
+        auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc{} && end == text.data() + text.size();
+    }
+
+    int usage(char const *program)
+    {
+        std::cerr << "usage: " << program << " [-j|--workers N] [--memory-budget BYTES] [--spill-dir PATH]\n"
+                  << "       " << program << " --build-index PATH\n"
+                  << "         both also take [--stop-words] [--stop-words-file PATH]\n"
+                  << "       " << program << " --index PATH [--keyword WORD | --prefix TEXT] [--verify]\n"
+                  << "  -j, --workers N        sort the rotations on N threads (0 uses all cores)\n"
+                  << "  --memory-budget BYTES  spill sorted runs to disk beyond BYTES of heap\n"
+                  << "  --spill-dir PATH       directory for the runs (default: system temporary directory)\n"
+                  << "  --stop-words           skip rotations starting with common English words\n"
+                  << "  --stop-words-file PATH skip rotations starting with any word of the file\n"
+                  << "  --build-index PATH     write the index of the input to PATH instead of printing it\n"
+                  << "  --index PATH           print from the index at PATH instead of reading input\n"
+                  << "  --keyword WORD         only lines starting with WORD, ignoring case\n"
+                  << "  --prefix TEXT          only lines whose first word starts with TEXT, ignoring case\n"
+                  << "  --verify               check the index's checksum first\n";
+        return 1;
+    }
+
+    // Prints from a mapped index: nothing is parsed, and only the pages the
+    // query reaches are read.
+    int printIndex(std::filesystem::path const &path, std::optional<std::string> const &query, bool prefix, bool verify)
+    {
+        text::IndexFile const file{path};
+        if (verify && !file.verify())
+        {
+            std::cerr << "checksum mismatch in " << path.string() << '\n';
+            return 1;
+        }
+        auto const rotations = !query ? file.rotations() : prefix ? file.withPrefix(*query)
+                                                                  : file.withKeyword(*query);
+        file.print(rotations, std::cout);
+        return 0;
+    }
+}
 
-auto main() -> int
+int main(int argc, char *argv[])
 {
+    text::KwicOptions options{};
+    std::filesystem::path buildIndex;
+    std::filesystem::path index;
+    std::optional<std::string> query;
+    bool prefix = false;
+    bool verify = false;
+    // Options that only apply when the input is printed, not with --build-index or --index.
+    bool printOptions = false;
+    // Options that only apply when the input is read, not with --index.
+    bool stopWordOptions = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view const arg{argv[i]};
+        bool const hasValue = i + 1 < argc;
+        printOptions = printOptions || arg == "-j" || arg == "--workers" || arg == "--memory-budget" || arg == "--spill-dir";
+        stopWordOptions = stopWordOptions || arg == "--stop-words" || arg == "--stop-words-file";
+        if ((arg == "-j" || arg == "--workers") && hasValue && parseNumber(argv[i + 1], options.workers))
+        {
+            ++i;
+            if (options.workers == 0)
+            {
+                options.workers = std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
+        else if (arg == "--memory-budget" && hasValue && parseNumber(argv[i + 1], options.memoryBudget))
+        {
+            ++i;
+        }
+        else if (arg == "--spill-dir" && hasValue)
+        {
+            options.spillDirectory = argv[++i];
+        }
+        else if (arg == "--stop-words")
+        {
+            options.stopWords.add(text::StopWords::english());
+        }
+        else if (arg == "--stop-words-file" && hasValue)
+        {
+            std::ifstream file{argv[++i]};
+            if (!file)
+            {
+                std::cerr << "cannot read " << argv[i] << '\n';
+                return 1;
+            }
+            options.stopWords.add(text::StopWords::load(file));
+        }
+        else if (arg == "--build-index" && hasValue)
+        {
+            buildIndex = argv[++i];
+        }
+        else if (arg == "--index" && hasValue)
+        {
+            index = argv[++i];
+        }
+        else if ((arg == "--keyword" || arg == "--prefix") && hasValue && !query)
+        {
+            prefix = arg == "--prefix";
+            query = argv[++i];
+        }
+        else if (arg == "--verify")
+        {
+            verify = true;
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    bool const queryWithoutIndex = index.empty() && (query || verify);
+    bool const indexWithBuildOptions = !index.empty() && (!buildIndex.empty() || printOptions || stopWordOptions);
+    bool const buildIndexWithPrintOptions = !buildIndex.empty() && printOptions;
+    if (queryWithoutIndex || indexWithBuildOptions || buildIndexWithPrintOptions)
+    {
+        return usage(argv[0]);
+    }
+
+    std::ios::sync_with_stdio(false);
+
+    if (!index.empty())
+    {
+        try
+        {
+            return printIndex(index, query, prefix, verify);
+        }
+        catch (std::exception const &error)
+        {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+    }
+
     std::cout << "=== KWIC - Keyword in Context ===" << std::endl;
     std::cout << "Enter lines of text (Ctrl+D to finish):" << std::endl;
     std::cout << std::endl;
 
-    text::kwic(std::cin, std::cout);
+    try
+    {
+        if (buildIndex.empty())
+        {
+            text::kwic(std::cin, std::cout, options);
+        }
+        else
+        {
+            text::KwicIndex kwicIndex{options.stopWords};
+            kwicIndex.add(std::cin);
+            text::IndexFile::write(kwicIndex, buildIndex);
+        }
+    }
+    catch (std::exception const &error)
+    {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
 
     return 0;
 }
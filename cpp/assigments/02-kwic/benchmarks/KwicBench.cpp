@@ -0,0 +1,698 @@
+#include "CaselessCompare.hpp"
+#include "Kwic.hpp"
+#include "KwicIndex.hpp"
+#include "KwicStages.hpp"
+#include "MultikeySort.hpp"
+#include "RotationWriter.hpp"
+#include "SuffixIndex.hpp"
+#include "Tokenizer.hpp"
+#include "Word.hpp"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Heap accounting for the whole benchmark binary: every allocation carries its
+// size in a header so the peak of live bytes can be tracked. Atomic because the
+// parallel kwic allocates from its workers.
+namespace
+{
+    std::atomic<std::size_t> liveBytes{};
+    std::atomic<std::size_t> peakBytes{};
+    constexpr std::size_t header = alignof(std::max_align_t);
+}
+
+void *operator new(std::size_t size)
+{
+    auto *block = static_cast<char *>(std::malloc(size + header));
+    if (!block)
+    {
+        throw std::bad_alloc{};
+    }
+    *reinterpret_cast<std::size_t *>(block) = size;
+    auto const live = liveBytes += size;
+    auto peak = peakBytes.load();
+    while (peak < live && !peakBytes.compare_exchange_weak(peak, live))
+    {
+    }
+    return block + header;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if (pointer)
+    {
+        auto *block = static_cast<char *>(pointer) - header;
+        liveBytes -= *reinterpret_cast<std::size_t *>(block);
+        std::free(block);
+    }
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+namespace
+{
+    // The former kwic(): every rotation is a full copy of its line.
+    void materializedKwic(std::istream &in, std::ostream &out)
+    {
+        using Line = std::vector<text::Word>;
+        std::set<Line> allRotations;
+        std::string inputLine;
+        while (std::getline(in, inputLine))
+        {
+            Line words;
+            std::istringstream lineStream(inputLine);
+            text::Word w;
+            while (lineStream >> w)
+            {
+                words.push_back(w);
+            }
+            for (std::size_t i = 0; i < words.size(); ++i)
+            {
+                Line rotation = words;
+                std::rotate(rotation.begin(), rotation.begin() + static_cast<std::ptrdiff_t>(i), rotation.end());
+                allRotations.insert(rotation);
+            }
+        }
+        for (auto const &line : allRotations)
+        {
+            for (auto const &w : line)
+            {
+                out << w << ' ';
+            }
+            out << '\n';
+        }
+    }
+
+    std::string corpus(std::size_t lines, std::size_t wordsPerLine)
+    {
+        std::string text;
+        unsigned state = 12345;
+        for (std::size_t l = 0; l < lines; ++l)
+        {
+            for (std::size_t w = 0; w < wordsPerLine; ++w)
+            {
+                state = state * 1103515245 + 12345;
+                std::size_t const length = 3 + (state >> 16) % 8;
+                for (std::size_t c = 0; c < length; ++c)
+                {
+                    state = state * 1103515245 + 12345;
+                    text += static_cast<char>('a' + (state >> 16) % 26);
+                }
+                text += ' ';
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    // Discards the output, whose size is the same for both variants.
+    struct NullBuffer : std::streambuf
+    {
+        int overflow(int c) override
+        {
+            return c;
+        }
+
+        std::streamsize xsputn(char const *, std::streamsize count) override
+        {
+            return count;
+        }
+    };
+
+    // Lines of ten words drawn from a skewed vocabulary, so most words repeat.
+    std::string repetitiveCorpus(std::size_t lines, std::size_t vocabularySize)
+    {
+        std::vector<std::string> vocabulary;
+        unsigned state = 6789;
+        auto next = [&state]
+        {
+            state = state * 1103515245 + 12345;
+            return state >> 16;
+        };
+        for (std::size_t i = 0; i < vocabularySize; ++i)
+        {
+            std::string word;
+            for (std::size_t c = 0, length = 3 + next() % 8; c < length; ++c)
+            {
+                word += static_cast<char>((c == 0 && next() % 4 == 0 ? 'A' : 'a') + next() % 26);
+            }
+            vocabulary.push_back(word);
+        }
+        std::string text;
+        for (std::size_t l = 0; l < lines; ++l)
+        {
+            for (std::size_t w = 0; w < 10; ++w)
+            {
+                // The product of two uniform picks favours small indices.
+                auto const pick = (next() % vocabularySize) * (next() % vocabularySize) / vocabularySize;
+                text += vocabulary[pick];
+                text += ' ';
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    void sequentialKwic(std::istream &in, std::ostream &out)
+    {
+        text::kwic(in, out);
+    }
+
+    template <typename Kwic>
+    std::size_t peakHeap(std::string const &text, Kwic kwic)
+    {
+        std::istringstream in{text};
+        NullBuffer discard;
+        std::ostream out{&discard};
+        auto const before = liveBytes.load();
+        peakBytes = before;
+        kwic(in, out);
+        return peakBytes - before;
+    }
+}
+
+TEST_CASE("kwic memory on long lines", "[benchmark]")
+{
+    for (std::size_t const wordsPerLine : {10, 100, 400})
+    {
+        auto const text = corpus(20'000 / wordsPerLine, wordsPerLine);
+        auto const materialized = peakHeap(text, materializedKwic);
+        auto const indexed = peakHeap(text, sequentialKwic);
+        std::cout << wordsPerLine << " words per line: materialized rotations " << materialized
+                  << " bytes peak, rotation store " << indexed << " bytes peak\n";
+    }
+}
+
+TEST_CASE("kwic time on long lines", "[benchmark]")
+{
+    auto const text = corpus(20, 400);
+
+    BENCHMARK("materialized rotations")
+    {
+        std::istringstream in{text};
+        std::ostringstream out;
+        materializedKwic(in, out);
+        return out.tellp();
+    };
+    BENCHMARK("rotation store")
+    {
+        std::istringstream in{text};
+        std::ostringstream out;
+        text::kwic(in, out);
+        return out.tellp();
+    };
+}
+
+TEST_CASE("kwic on a repetitive corpus", "[benchmark]")
+{
+    auto const text = repetitiveCorpus(20'000, 5'000);
+    std::cout << "repetitive corpus: materialized rotations " << peakHeap(text, materializedKwic)
+              << " bytes peak, interned rotation store " << peakHeap(text, sequentialKwic) << " bytes peak\n";
+
+    BENCHMARK("materialized rotations")
+    {
+        std::istringstream in{text};
+        std::ostringstream out;
+        materializedKwic(in, out);
+        return out.tellp();
+    };
+    BENCHMARK("interned rotation store")
+    {
+        std::istringstream in{text};
+        std::ostringstream out;
+        text::kwic(in, out);
+        return out.tellp();
+    };
+}
+
+TEST_CASE("tokenizing a corpus", "[benchmark]")
+{
+    auto const text = repetitiveCorpus(20'000, 5'000);
+
+    BENCHMARK("getline, istringstream and Word::read")
+    {
+        std::size_t letters = 0;
+        std::istringstream in{text};
+        for (std::string line; std::getline(in, line);)
+        {
+            std::istringstream lineStream{line};
+            text::Word w;
+            while (lineStream >> w)
+            {
+                letters += w.spelling().size();
+            }
+        }
+        return letters;
+    };
+    BENCHMARK("LineReader and WordScanner")
+    {
+        std::size_t letters = 0;
+        std::istringstream in{text};
+        text::LineReader lines{in};
+        for (std::string_view line; lines.next(line);)
+        {
+            text::WordScanner scanner{line};
+            for (auto word = scanner.next(); !word.empty(); word = scanner.next())
+            {
+                letters += word.size();
+            }
+        }
+        return letters;
+    };
+}
+
+TEST_CASE("writing the sorted rotations", "[benchmark]")
+{
+    auto const text = repetitiveCorpus(20'000, 5'000);
+    text::KwicIndex index;
+    std::istringstream in{text};
+    index.add(in);
+
+    BENCHMARK("RotationStore::print per rotation")
+    {
+        std::ostringstream out;
+        for (auto const rotation : index.all())
+        {
+            index.print(rotation, out);
+            out << '\n';
+        }
+        return out.tellp();
+    };
+    BENCHMARK("RotationWriter")
+    {
+        std::ostringstream out;
+        text::RotationWriter writer{out};
+        for (auto const rotation : index.all())
+        {
+            writer.write(index.rotations(), rotation);
+        }
+        writer.flush();
+        return out.tellp();
+    };
+}
+
+TEST_CASE("keyword lookups while lines are added", "[benchmark]")
+{
+    auto const text = repetitiveCorpus(20'000, 5'000);
+    std::vector<std::string> lines;
+    std::istringstream in{text};
+    for (std::string line; std::getline(in, line);)
+    {
+        lines.push_back(line);
+    }
+
+    BENCHMARK("kwic index: 100 added lines, each followed by a lookup")
+    {
+        text::KwicIndex index;
+        std::istringstream all{text};
+        index.add(all);
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < 100; ++i)
+        {
+            index.addLine(lines[i]);
+            found += index.withKeyword(lines[i].substr(0, lines[i].find(' '))).size();
+        }
+        return found;
+    };
+    BENCHMARK("kwic index: building it once")
+    {
+        text::KwicIndex index;
+        std::istringstream all{text};
+        index.add(all);
+        return index.size();
+    };
+}
+
+TEST_CASE("suffix index against materialized rotations", "[benchmark]")
+{
+    auto const text = repetitiveCorpus(20'000, 5'000);
+    std::cout << "repetitive corpus: materialized rotations " << peakHeap(text, materializedKwic)
+              << " bytes peak, rotation store " << peakHeap(text, sequentialKwic)
+              << " bytes peak, suffix index " << peakHeap(text, [](std::istream &in, std::ostream &out)
+                                                          { text::SuffixIndex{in}.print(out); })
+              << " bytes peak\n";
+
+    BENCHMARK("materialized rotations")
+    {
+        std::istringstream in{text};
+        std::ostringstream out;
+        materializedKwic(in, out);
+        return out.tellp();
+    };
+    BENCHMARK("suffix index construction")
+    {
+        std::istringstream in{text};
+        return text::SuffixIndex{in}.rotations().size();
+    };
+
+    std::istringstream in{text};
+    text::SuffixIndex const index{in};
+    std::vector<std::string> keywords;
+    std::istringstream words{text};
+    for (std::string word; keywords.size() < 1000 && words >> word;)
+    {
+        keywords.push_back(word);
+    }
+    BENCHMARK("suffix index: 1000 keyword lookups")
+    {
+        std::size_t found = 0;
+        for (auto const &keyword : keywords)
+        {
+            found += index.find(keyword).size();
+        }
+        return found;
+    };
+}
+
+TEST_CASE("external kwic heap within a budget", "[benchmark]")
+{
+    auto const text = repetitiveCorpus(20'000, 5'000);
+    std::cout << "repetitive corpus: in memory " << peakHeap(text, sequentialKwic) << " bytes peak";
+    for (std::size_t const budget : {256 * 1024, 1024 * 1024})
+    {
+        text::KwicOptions options{};
+        options.memoryBudget = budget;
+        std::size_t const peak = peakHeap(text, [&options](std::istream &in, std::ostream &out)
+                                          { text::kwic(in, out, options); });
+        std::cout << ", budget " << budget << ": " << peak << " bytes peak";
+    }
+    std::cout << '\n';
+}
+
+TEST_CASE("parallel kwic on a repetitive corpus", "[benchmark]")
+{
+    auto const text = repetitiveCorpus(20'000, 5'000);
+    std::cout << "parallel kwic on " << std::thread::hardware_concurrency() << " hardware threads\n";
+
+    for (unsigned const workers : {1u, 2u, 4u, 8u})
+    {
+        BENCHMARK("workers: " + std::to_string(workers))
+        {
+            std::istringstream in{text};
+            std::ostringstream out;
+            text::kwic(in, out, text::KwicOptions{workers});
+            return out.tellp();
+        };
+    }
+}
+
+namespace
+{
+    // The per-character loop Word used before the shared kernel.
+    int toLowerCompare(std::string const &lhs, std::string const &rhs)
+    {
+        auto lhsIt = lhs.begin();
+        auto rhsIt = rhs.begin();
+        while (lhsIt != lhs.end() && rhsIt != rhs.end())
+        {
+            char const lhsChar = static_cast<char>(std::tolower(static_cast<unsigned char>(*lhsIt++)));
+            char const rhsChar = static_cast<char>(std::tolower(static_cast<unsigned char>(*rhsIt++)));
+            if (lhsChar != rhsChar)
+            {
+                return lhsChar < rhsChar ? -1 : 1;
+            }
+        }
+        return lhsIt == lhs.end() ? (rhsIt == rhs.end() ? 0 : -1) : 1;
+    }
+
+    // Pairs that agree up to the last character, in different case.
+    std::vector<std::pair<std::string, std::string>> pairs(std::size_t length)
+    {
+        std::vector<std::pair<std::string, std::string>> result;
+        unsigned state = 4242;
+        for (std::size_t p = 0; p < 1000; ++p)
+        {
+            std::string lhs;
+            std::string rhs;
+            for (std::size_t c = 0; c < length; ++c)
+            {
+                state = state * 1103515245 + 12345;
+                char const letter = static_cast<char>('a' + (state >> 16) % 26);
+                lhs += letter;
+                rhs += static_cast<char>(letter - 'a' + 'A');
+            }
+            rhs.back() = 'z';
+            result.emplace_back(lhs, rhs);
+        }
+        return result;
+    }
+}
+
+TEST_CASE("case-insensitive compare on short and long words", "[benchmark]")
+{
+    for (std::size_t const length : {6, 40, 1000})
+    {
+        auto const words = pairs(length);
+        BENCHMARK("tolower loop, " + std::to_string(length) + " characters")
+        {
+            int sum = 0;
+            for (auto const &[lhs, rhs] : words)
+            {
+                sum += toLowerCompare(lhs, rhs);
+            }
+            return sum;
+        };
+        BENCHMARK("ascii::compareCaseless, " + std::to_string(length) + " characters")
+        {
+            int sum = 0;
+            for (auto const &[lhs, rhs] : words)
+            {
+                sum += ascii::compareCaseless(lhs, rhs);
+            }
+            return sum;
+        };
+    }
+}
+
+namespace
+{
+    // Word as it was before the inline redesign: a std::string compared by the shared kernel.
+    struct StringWord
+    {
+        std::string value;
+
+        bool operator<(StringWord const &other) const
+        {
+            return ascii::compareCaseless(value, other.value) < 0;
+        }
+    };
+
+    std::vector<std::string> randomWords(std::size_t count)
+    {
+        std::vector<std::string> words;
+        unsigned state = 777;
+        auto next = [&state]
+        {
+            state = state * 1103515245 + 12345;
+            return state >> 16;
+        };
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::string word;
+            for (std::size_t c = 0, length = 3 + next() % 12; c < length; ++c)
+            {
+                word += static_cast<char>((next() % 4 == 0 ? 'A' : 'a') + next() % 26);
+            }
+            words.push_back(word);
+        }
+        return words;
+    }
+}
+
+TEST_CASE("std::sort over a million words", "[benchmark]")
+{
+    auto const spellings = randomWords(1'000'000);
+    std::vector<StringWord> stringWords;
+    std::vector<text::Word> words;
+    for (auto const &spelling : spellings)
+    {
+        stringWords.push_back(StringWord{spelling});
+        words.emplace_back(spelling);
+    }
+
+    BENCHMARK("std::string and caseless compare")
+    {
+        auto copy = stringWords;
+        std::sort(copy.begin(), copy.end());
+        return copy.size();
+    };
+    BENCHMARK("Word with inline letters and folded prefix")
+    {
+        auto copy = words;
+        std::sort(copy.begin(), copy.end());
+        return copy.size();
+    };
+}
+
+namespace
+{
+    // Lines that repeat one long phrase and differ in a few trailing words, so
+    // rotations share long prefixes.
+    std::string sharedPrefixCorpus(std::size_t lines, std::size_t phraseWords)
+    {
+        std::string phrase;
+        for (std::size_t w = 0; w < phraseWords; ++w)
+        {
+            phrase += "word" + std::string(1, static_cast<char>('a' + w % 26)) + std::string(1, static_cast<char>('a' + w / 26 % 26)) + ' ';
+        }
+        std::string text;
+        unsigned state = 31337;
+        for (std::size_t l = 0; l < lines; ++l)
+        {
+            text += phrase;
+            for (std::size_t w = 0; w < 3; ++w)
+            {
+                state = state * 1103515245 + 12345;
+                text += std::string(1, static_cast<char>('a' + (state >> 16) % 26)) + "tail ";
+            }
+            text += '\n';
+        }
+        return text;
+    }
+
+    void sortBenchmarks(std::string const &text)
+    {
+        text::RotationStore store;
+        std::vector<text::Rotation> rotations;
+        text::LineReader lines{text};
+        for (std::string_view line; lines.next(line);)
+        {
+            text::addLine(line, store, rotations);
+        }
+        store.rank();
+
+        BENCHMARK("std::set of materialized rotations")
+        {
+            std::istringstream in{text};
+            NullBuffer discard;
+            std::ostream out{&discard};
+            materializedKwic(in, out);
+            return out.good();
+        };
+        BENCHMARK("stable_sort by rank comparisons")
+        {
+            auto copy = rotations;
+            std::stable_sort(copy.begin(), copy.end(), [&store](text::Rotation lhs, text::Rotation rhs)
+                             { return store.less(lhs, rhs); });
+            copy.erase(std::unique(copy.begin(), copy.end(), [&store](text::Rotation lhs, text::Rotation rhs)
+                                   { return !store.less(lhs, rhs); }),
+                       copy.end());
+            return copy.size();
+        };
+        BENCHMARK("multikey quicksort")
+        {
+            auto copy = rotations;
+            text::multikeySortRotations(store, copy);
+            return copy.size();
+        };
+    }
+}
+
+TEST_CASE("sorting rotations with long shared prefixes", "[benchmark]")
+{
+    sortBenchmarks(sharedPrefixCorpus(500, 40));
+}
+
+TEST_CASE("sorting rotations of a repetitive corpus", "[benchmark]")
+{
+    sortBenchmarks(repetitiveCorpus(20'000, 5'000));
+}
+
+namespace
+{
+    // Ten-word lines in which about as many words are English stop words as
+    // in running English text, i.e. roughly every other one.
+    std::string englishLikeCorpus(std::size_t lines)
+    {
+        auto const content = repetitiveCorpus(lines, 5'000);
+        std::istringstream words{content};
+        std::string text;
+        unsigned state = 4242;
+        std::size_t count = 0;
+        for (std::string word; words >> word;)
+        {
+            state = state * 1103515245 + 12345;
+            if ((state >> 16) % 2 == 0)
+            {
+                state = state * 1103515245 + 12345;
+                text += text::stopwords::english[(state >> 16) % text::stopwords::english.size()];
+            }
+            else
+            {
+                text += word;
+            }
+            text += ++count % 10 == 0 ? '\n' : ' ';
+        }
+        return text;
+    }
+
+    std::vector<text::Rotation> rotationsOf(std::string const &text, text::RotationStore &store, text::StopWords const &stopWords)
+    {
+        std::vector<text::Rotation> rotations;
+        text::LineReader lines{text};
+        for (std::string_view line; lines.next(line);)
+        {
+            text::addLine(line, store, rotations, stopWords);
+        }
+        store.rank();
+        return rotations;
+    }
+}
+
+TEST_CASE("stop-word filtering on English-like text", "[benchmark]")
+{
+    auto const text = englishLikeCorpus(20'000);
+    text::RotationStore allStore;
+    auto const all = rotationsOf(text, allStore, text::StopWords{});
+    text::RotationStore filteredStore;
+    auto const filtered = rotationsOf(text, filteredStore, text::StopWords::english());
+    std::cout << "rotations to sort: " << all.size() << " without filtering, " << filtered.size()
+              << " without those starting with a stop word\n";
+
+    BENCHMARK("multikey sort of all rotations")
+    {
+        auto copy = all;
+        text::multikeySortRotations(allStore, copy);
+        return copy.size();
+    };
+    BENCHMARK("multikey sort of the filtered rotations")
+    {
+        auto copy = filtered;
+        text::multikeySortRotations(filteredStore, copy);
+        return copy.size();
+    };
+    for (bool const filter : {false, true})
+    {
+        BENCHMARK(filter ? "kwic with English stop words" : "kwic without stop words")
+        {
+            std::istringstream in{text};
+            NullBuffer discard;
+            std::ostream out{&discard};
+            text::KwicOptions options{};
+            if (filter)
+            {
+                options.stopWords = text::StopWords::english();
+            }
+            text::kwic(in, out, options);
+            return out.good();
+        };
+    }
+}
@@ -0,0 +1,379 @@
+#include "ExternalKwic.hpp"
+#include "CaselessCompare.hpp"
+#include "KwicStages.hpp"
+#include "RotationWriter.hpp"
+#include "Rotations.hpp"
+#include "Tokenizer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace text
+{
+
+    namespace
+    {
+        // Every open run gets an I/O buffer of an eighth of the budget within these
+        // bounds, so the merge fan-in follows from the budget.
+        constexpr std::size_t minRunBuffer = 4 * 1024;
+        constexpr std::size_t maxRunBuffer = 64 * 1024;
+        // Reading the input and writing a run need a buffer each at any budget.
+        constexpr std::size_t minMemoryBudget = 2 * minRunBuffer;
+        // Bounds the files open at once whatever the budget.
+        constexpr std::size_t maxFanIn = 64;
+
+        // A temporary file that is removed again with this object.
+        class RunFile
+        {
+        public:
+            explicit RunFile(std::filesystem::path const &directory)
+            {
+                std::string name = (directory / "kwic-run-XXXXXX").string();
+                int const fd = ::mkstemp(name.data());
+                if (fd == -1)
+                {
+                    throw std::system_error{errno, std::generic_category(), "cannot create a run file in " + directory.string()};
+                }
+                ::close(fd);
+                path = std::move(name);
+            }
+
+            RunFile(RunFile &&other) noexcept
+                : path{std::exchange(other.path, {})}
+            {
+            }
+
+            RunFile &operator=(RunFile &&) = delete;
+
+            ~RunFile()
+            {
+                if (!path.empty())
+                {
+                    std::error_code ignored;
+                    std::filesystem::remove(path, ignored);
+                }
+            }
+
+            std::filesystem::path const &name() const
+            {
+                return path;
+            }
+
+        private:
+            std::filesystem::path path;
+        };
+
+        // Negative, zero or positive as lhs orders before, equal to or after rhs,
+        // in the order RotationStore::less() gives the same word sequences.
+        template <typename Lhs, typename Rhs>
+        int compareRecords(Lhs const &lhs, Rhs const &rhs)
+        {
+            std::size_t const size = std::min(lhs.size(), rhs.size());
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (int const order = ascii::compareCaseless(lhs[i], rhs[i]))
+                {
+                    return order;
+                }
+            }
+            return (lhs.size() > rhs.size()) - (lhs.size() < rhs.size());
+        }
+
+        // Reports errno, or EIO if the failure set none, e.g. a malformed record.
+        [[noreturn]] void failed(std::filesystem::path const &path, char const *what, int error = errno)
+        {
+            throw std::system_error{error != 0 ? error : EIO, std::generic_category(), std::string{what} + " " + path.string()};
+        }
+
+        // A run is a sequence of sorted rotations. Each record is the number of
+        // leading words it shares with the previous record, the number of words
+        // that follow, and those words as length and spelling. All numbers are
+        // LEB128 varints, so neighbouring rotations of a run cost little more
+        // than their differing suffixes.
+        class RunWriter
+        {
+        public:
+            RunWriter(std::filesystem::path const &path, std::size_t bufferSize)
+                : buffer(bufferSize), path{path}
+            {
+                out.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                errno = 0;
+                out.open(path, std::ios::binary | std::ios::trunc);
+                if (!out)
+                {
+                    failed(path, "cannot write");
+                }
+            }
+
+            void write(std::span<std::string_view const> words)
+            {
+                std::size_t shared = 0;
+                while (shared < words.size() && shared < previous.size() && words[shared] == previous[shared])
+                {
+                    ++shared;
+                }
+                writeNumber(shared);
+                writeNumber(words.size() - shared);
+                previous.resize(words.size());
+                for (std::size_t i = shared; i < words.size(); ++i)
+                {
+                    writeNumber(words[i].size());
+                    out.write(words[i].data(), static_cast<std::streamsize>(words[i].size()));
+                    previous[i] = words[i];
+                }
+            }
+
+            void close()
+            {
+                out.close();
+                if (!out)
+                {
+                    failed(path, "cannot write");
+                }
+            }
+
+        private:
+            void writeNumber(std::size_t value)
+            {
+                while (value >= 0x80)
+                {
+                    out.put(static_cast<char>(value | 0x80));
+                    value >>= 7;
+                }
+                out.put(static_cast<char>(value));
+            }
+
+            std::vector<char> buffer;
+            std::filesystem::path path;
+            std::ofstream out;
+            std::vector<std::string> previous;
+        };
+
+        class RunReader
+        {
+        public:
+            RunReader(std::filesystem::path const &path, std::size_t bufferSize)
+                : buffer(bufferSize), path{path}
+            {
+                in.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                errno = 0;
+                in.open(path, std::ios::binary);
+                if (!in)
+                {
+                    failed(path, "cannot read");
+                }
+            }
+
+            // Advances to the next record; false at the end of the run.
+            bool next()
+            {
+                if (in.peek() == std::ifstream::traits_type::eof())
+                {
+                    return false;
+                }
+                std::size_t const shared = readNumber();
+                std::size_t const count = readNumber();
+                if (shared > words.size())
+                {
+                    failed(path, "corrupt run file", EIO);
+                }
+                words.resize(shared + count);
+                for (std::size_t i = shared; i < words.size(); ++i)
+                {
+                    words[i].resize(readNumber());
+                    in.read(words[i].data(), static_cast<std::streamsize>(words[i].size()));
+                }
+                if (!in)
+                {
+                    failed(path, "corrupt run file", EIO);
+                }
+                record.assign(words.begin(), words.end());
+                return true;
+            }
+
+            std::vector<std::string_view> const &current() const
+            {
+                return record;
+            }
+
+        private:
+            std::size_t readNumber()
+            {
+                std::size_t value{};
+                for (unsigned shift = 0; shift < 64; shift += 7)
+                {
+                    auto const byte = in.get();
+                    if (byte == std::ifstream::traits_type::eof())
+                    {
+                        break;
+                    }
+                    value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+                    if ((byte & 0x80) == 0)
+                    {
+                        return value;
+                    }
+                }
+                failed(path, "corrupt run file", EIO);
+            }
+
+            std::vector<char> buffer;
+            std::filesystem::path path;
+            std::ifstream in;
+            std::vector<std::string> words;
+            std::vector<std::string_view> record;
+        };
+
+        // Streams the records of all runs in order to emit(). Of equal records
+        // only the one from the earliest run is emitted.
+        template <typename Emit>
+        void mergeRuns(std::span<RunFile const> runs, std::size_t bufferSize, Emit emit)
+        {
+            std::vector<std::unique_ptr<RunReader>> readers;
+            for (auto const &run : runs)
+            {
+                readers.push_back(std::make_unique<RunReader>(run.name(), bufferSize));
+            }
+            auto const after = [&readers](std::size_t lhs, std::size_t rhs)
+            {
+                int const order = compareRecords(readers[lhs]->current(), readers[rhs]->current());
+                return order != 0 ? order > 0 : lhs > rhs;
+            };
+            std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(after)> heap{after};
+            for (std::size_t i = 0; i < readers.size(); ++i)
+            {
+                if (readers[i]->next())
+                {
+                    heap.push(i);
+                }
+            }
+
+            std::vector<std::string> last;
+            bool any = false;
+            while (!heap.empty())
+            {
+                auto const run = heap.top();
+                heap.pop();
+                auto const &record = readers[run]->current();
+                if (!any || compareRecords(last, record) != 0)
+                {
+                    emit(record);
+                    last.assign(record.begin(), record.end());
+                    any = true;
+                }
+                if (readers[run]->next())
+                {
+                    heap.push(run);
+                }
+            }
+        }
+
+        void writeRun(RotationStore const &store, std::vector<Rotation> const &rotations, std::filesystem::path const &path, std::size_t bufferSize)
+        {
+            RunWriter writer{path, bufferSize};
+            std::vector<std::string_view> words;
+            for (auto const rotation : rotations)
+            {
+                WordIds const &ids = store.line(rotation.line);
+                words.clear();
+                for (std::size_t i = 0; i < ids.size(); ++i)
+                {
+                    words.push_back(store.vocabulary().spelling(ids[(rotation.offset + i) % ids.size()]));
+                }
+                writer.write(words);
+            }
+            writer.close();
+        }
+    }
+
+    void externalKwic(std::istream &in, std::ostream &out, std::size_t memoryBudget, std::filesystem::path const &directory, StopWords const &stopWords)
+    {
+        if (memoryBudget < minMemoryBudget)
+        {
+            throw std::invalid_argument{"memory budget below " + std::to_string(minMemoryBudget) + " bytes"};
+        }
+        auto const spillDirectory = directory.empty() ? std::filesystem::temp_directory_path() : directory;
+        std::size_t const bufferSize = std::clamp(memoryBudget / 8, minRunBuffer, maxRunBuffer);
+        std::vector<RunFile> runs;
+        RotationStore store;
+        std::vector<Rotation> rotations;
+
+        auto spill = [&]
+        {
+            store.rank();
+            sortRotations(store, rotations);
+            writeRun(store, rotations, runs.emplace_back(spillDirectory).name(), bufferSize);
+            store = RotationStore{};
+            rotations = std::vector<Rotation>{};
+        };
+
+        LineReader lines{in, bufferSize};
+        for (std::string_view inputLine; lines.next(inputLine);)
+        {
+            if (inputLine.empty())
+            {
+                continue;
+            }
+            addLine(inputLine, store, rotations, stopWords);
+            // The rotations count five times: sorting them takes a 12-byte item,
+            // about two symbols and a result slot each besides the array itself.
+            // Reading the input and spilling each take one more buffer.
+            if (store.memoryUsage() + 5 * rotations.capacity() * sizeof(Rotation) + 2 * bufferSize > memoryBudget)
+            {
+                spill();
+            }
+        }
+
+        if (runs.empty())
+        {
+            store.rank();
+            sortRotations(store, rotations);
+            RotationWriter writer{out, bufferSize};
+            for (auto const rotation : rotations)
+            {
+                writer.write(store, rotation);
+            }
+            return;
+        }
+        if (!rotations.empty())
+        {
+            spill();
+        }
+
+        // Runs beyond what half the budget can buffer at once, next to the buffer
+        // of the run being written, are merged in passes. The other half is left
+        // for the current records and the merge bookkeeping.
+        std::size_t const fanIn = std::min(std::max<std::size_t>(3, memoryBudget / bufferSize / 2) - 1, maxFanIn);
+        while (runs.size() > fanIn)
+        {
+            std::vector<RunFile> merged;
+            for (std::size_t first = 0; first < runs.size(); first += fanIn)
+            {
+                auto const group = std::span<RunFile const>{runs}.subspan(first, std::min(fanIn, runs.size() - first));
+                RunWriter writer{merged.emplace_back(spillDirectory).name(), bufferSize};
+                mergeRuns(group, bufferSize, [&writer](std::span<std::string_view const> words)
+                          { writer.write(words); });
+                writer.close();
+            }
+            runs = std::move(merged);
+        }
+        RotationWriter writer{out, bufferSize};
+        mergeRuns(runs, bufferSize, [&writer](std::span<std::string_view const> words)
+                  { writer.write(words); });
+    }
+
+}
@@ -0,0 +1,23 @@
+#ifndef EXTERNALKWIC_HPP_
+#define EXTERNALKWIC_HPP_
+
+#include "StopWords.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <iosfwd>
+
+namespace text
+{
+
+    // kwic() within roughly `memoryBudget` bytes of heap. Whenever the rotations
+    // collected so far exceed the budget they are sorted and spilled as a run file
+    // to `directory` (the system temporary directory if empty). The runs are then
+    // merged as a stream, dropping rotations equal to one of an earlier run.
+    // Output is byte-identical to kwic(). Throws std::system_error on I/O failure
+    // and std::invalid_argument for a budget too small for the I/O buffers.
+    void externalKwic(std::istream &in, std::ostream &out, std::size_t memoryBudget, std::filesystem::path const &directory, StopWords const &stopWords);
+
+}
+
+#endif
@@ -0,0 +1,381 @@
+#include "IndexFile.hpp"
+#include "CaselessCompare.hpp"
+#include "RotationWriter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace text
+{
+
+    namespace
+    {
+        constexpr std::array<char, 8> magic{'K', 'W', 'I', 'C', 'I', 'D', 'X', '\0'};
+        // Reads back differently on a machine of the other byte order.
+        constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+        struct Header
+        {
+            std::array<char, 8> magic;
+            std::uint32_t version;
+            std::uint32_t byteOrder;
+            std::uint64_t words;
+            std::uint64_t lines;
+            std::uint64_t lineWords;
+            std::uint64_t rotations;
+            std::uint64_t spellingBytes;
+            std::uint64_t checksum;
+        };
+
+        static_assert(sizeof(Header) == 64 && std::is_trivially_copyable_v<Header>);
+        static_assert(sizeof(Rotation) == 8 && std::is_trivially_copyable_v<Rotation>);
+
+        constexpr std::uint64_t padded(std::uint64_t size)
+        {
+            return (size + 7) / 8 * 8;
+        }
+
+        // FNV-1a over 64-bit words rather than bytes; sections are padded, so the
+        // body is always a whole number of words.
+        constexpr std::uint64_t checksumSeed = 0xcbf29ce484222325;
+
+        std::uint64_t mix(std::uint64_t hash, std::uint64_t word)
+        {
+            return (hash ^ word) * 0x100000001b3;
+        }
+
+        [[noreturn]] void failed(std::filesystem::path const &path, char const *what)
+        {
+            throw std::system_error{std::make_error_code(std::errc::io_error), std::string{what} + " " + path.string()};
+        }
+
+        [[noreturn]] void corrupt(char const *what)
+        {
+            throw std::runtime_error{std::string{"corrupt KWIC index: "} + what};
+        }
+
+        // Writes the body after a placeholder header, checksumming as it goes.
+        class BodyWriter
+        {
+        public:
+            explicit BodyWriter(std::filesystem::path const &path)
+                : buffer(64 * 1024), path{path}
+            {
+                out.rdbuf()->pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                out.open(path, std::ios::binary | std::ios::trunc);
+                if (!out)
+                {
+                    failed(path, "cannot write");
+                }
+                Header const placeholder{};
+                out.write(reinterpret_cast<char const *>(&placeholder), sizeof(placeholder));
+            }
+
+            template <typename T>
+            void write(T const &value)
+            {
+                write(&value, sizeof(value));
+            }
+
+            void write(void const *data, std::size_t size)
+            {
+                out.write(static_cast<char const *>(data), static_cast<std::streamsize>(size));
+                auto const *bytes = static_cast<char const *>(data);
+                while (size != 0)
+                {
+                    std::size_t const chunk = std::min(size, sizeof(pending) - pendingSize);
+                    std::memcpy(reinterpret_cast<char *>(&pending) + pendingSize, bytes, chunk);
+                    pendingSize += chunk;
+                    bytes += chunk;
+                    size -= chunk;
+                    if (pendingSize == sizeof(pending))
+                    {
+                        hash = mix(hash, pending);
+                        pending = 0;
+                        pendingSize = 0;
+                    }
+                }
+            }
+
+            // Ends a section on an 8-byte boundary.
+            void pad()
+            {
+                if (pendingSize != 0)
+                {
+                    std::array<char, 8> const zeros{};
+                    write(zeros.data(), sizeof(pending) - pendingSize);
+                }
+            }
+
+            void close(Header header)
+            {
+                header.checksum = hash;
+                out.seekp(0);
+                out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+                out.close();
+                if (!out)
+                {
+                    failed(path, "cannot write");
+                }
+            }
+
+        private:
+            std::vector<char> buffer;
+            std::filesystem::path path;
+            std::ofstream out;
+            std::uint64_t hash{checksumSeed};
+            std::uint64_t pending{};
+            std::size_t pendingSize{};
+        };
+
+        template <typename T>
+        std::span<T const> section(char const *&cursor, std::uint64_t count)
+        {
+            std::span<T const> const result{reinterpret_cast<T const *>(cursor), static_cast<std::size_t>(count)};
+            cursor += padded(count * sizeof(T));
+            return result;
+        }
+    }
+
+    void IndexFile::write(KwicIndex const &index, std::filesystem::path const &path)
+    {
+        auto const &store = index.rotations();
+        auto const &vocabulary = store.vocabulary();
+
+        Header header{magic, version, byteOrderMark, vocabulary.size(), store.lineCount(), 0, index.size(), 0, 0};
+        BodyWriter out{path};
+
+        std::uint64_t offset = 0;
+        out.write(offset);
+        for (WordId id = 0; id < vocabulary.size(); ++id)
+        {
+            offset += vocabulary.spelling(id).size();
+            out.write(offset);
+        }
+        header.spellingBytes = offset;
+        for (WordId id = 0; id < vocabulary.size(); ++id)
+        {
+            auto const spelling = vocabulary.spelling(id);
+            out.write(spelling.data(), spelling.size());
+        }
+        out.pad();
+
+        offset = 0;
+        out.write(offset);
+        for (std::uint32_t line = 0; line < store.lineCount(); ++line)
+        {
+            offset += store.line(line).size();
+            out.write(offset);
+        }
+        header.lineWords = offset;
+        for (std::uint32_t line = 0; line < store.lineCount(); ++line)
+        {
+            auto const &words = store.line(line);
+            out.write(words.data(), words.size() * sizeof(WordId));
+        }
+        out.pad();
+
+        for (Rotation const rotation : index.all())
+        {
+            out.write(rotation);
+        }
+        out.close(header);
+    }
+
+    IndexFile::IndexFile(std::filesystem::path const &path)
+    {
+        int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            throw std::system_error{errno, std::generic_category(), "cannot open " + path.string()};
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            ::close(fd);
+            failed(path, "not a regular file:");
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        if (size < sizeof(Header))
+        {
+            ::close(fd);
+            corrupt("shorter than its header");
+        }
+        void *const mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        int const error = errno;
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::system_error{error, std::generic_category(), "cannot map " + path.string()};
+        }
+        address = mapped;
+        // Queries jump around the file; read-ahead would fetch pages never used.
+        ::madvise(mapped, size, MADV_RANDOM);
+
+        try
+        {
+            Header header;
+            std::memcpy(&header, address, sizeof(header));
+            if (header.magic != magic)
+            {
+                corrupt("bad magic number");
+            }
+            if (header.byteOrder != byteOrderMark || header.version != version)
+            {
+                throw std::runtime_error{"unsupported KWIC index version or byte order"};
+            }
+            // Guards the size computation below against overflow.
+            constexpr std::uint64_t limit = std::uint64_t{1} << 40;
+            if (header.words >= limit || header.lines >= limit || header.lineWords >= limit ||
+                header.rotations >= limit || header.spellingBytes >= limit)
+            {
+                corrupt("implausible counts");
+            }
+            std::uint64_t const expected = sizeof(Header) + (header.words + 1) * 8 + padded(header.spellingBytes) +
+                                           (header.lines + 1) * 8 + padded(header.lineWords * sizeof(WordId)) +
+                                           header.rotations * sizeof(Rotation);
+            if (expected != size)
+            {
+                corrupt("size does not match its header");
+            }
+
+            char const *cursor = static_cast<char const *>(address) + sizeof(Header);
+            wordOffsets = section<std::uint64_t>(cursor, header.words + 1);
+            spellings = std::string_view{cursor, static_cast<std::size_t>(header.spellingBytes)};
+            cursor += padded(header.spellingBytes);
+            lineOffsets = section<std::uint64_t>(cursor, header.lines + 1);
+            lineWords = section<WordId>(cursor, header.lineWords);
+            table = section<Rotation>(cursor, header.rotations);
+            checksum = header.checksum;
+        }
+        catch (...)
+        {
+            ::munmap(const_cast<void *>(address), size);
+            throw;
+        }
+    }
+
+    IndexFile::~IndexFile()
+    {
+        ::munmap(const_cast<void *>(address), size);
+    }
+
+    bool IndexFile::verify() const
+    {
+        auto const *body = static_cast<char const *>(address) + sizeof(Header);
+        std::uint64_t hash = checksumSeed;
+        for (std::size_t i = 0; i < size - sizeof(Header); i += sizeof(std::uint64_t))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, body + i, sizeof(word));
+            hash = mix(hash, word);
+        }
+        return hash == checksum;
+    }
+
+    std::size_t IndexFile::wordCount() const
+    {
+        return wordOffsets.size() - 1;
+    }
+
+    std::size_t IndexFile::lineCount() const
+    {
+        return lineOffsets.size() - 1;
+    }
+
+    std::string_view IndexFile::spelling(WordId id) const
+    {
+        if (id >= wordCount() || wordOffsets[id] > wordOffsets[id + 1] || wordOffsets[id + 1] > spellings.size())
+        {
+            corrupt("word out of range");
+        }
+        return spellings.substr(wordOffsets[id], wordOffsets[id + 1] - wordOffsets[id]);
+    }
+
+    std::span<WordId const> IndexFile::line(std::uint32_t id) const
+    {
+        if (id >= lineCount() || lineOffsets[id] > lineOffsets[id + 1] || lineOffsets[id + 1] > lineWords.size())
+        {
+            corrupt("line out of range");
+        }
+        return lineWords.subspan(lineOffsets[id], lineOffsets[id + 1] - lineOffsets[id]);
+    }
+
+    std::span<Rotation const> IndexFile::rotations() const
+    {
+        return table;
+    }
+
+    std::span<Rotation const> IndexFile::withKeyword(std::string_view keyword) const
+    {
+        return find(keyword, false);
+    }
+
+    std::span<Rotation const> IndexFile::withPrefix(std::string_view prefix) const
+    {
+        return find(prefix, true);
+    }
+
+    void IndexFile::print(std::span<Rotation const> rotations, std::ostream &out) const
+    {
+        RotationWriter writer{out};
+        std::vector<std::string_view> words;
+        for (Rotation const rotation : rotations)
+        {
+            auto const ids = line(rotation.line);
+            if (rotation.offset >= ids.size())
+            {
+                corrupt("rotation out of range");
+            }
+            words.clear();
+            for (std::size_t i = rotation.offset; i < ids.size(); ++i)
+            {
+                words.push_back(spelling(ids[i]));
+            }
+            for (std::size_t i = 0; i < rotation.offset; ++i)
+            {
+                words.push_back(spelling(ids[i]));
+            }
+            writer.write(words);
+        }
+        writer.flush();
+    }
+
+    // Rotations whose first word matches are contiguous, since rotations order
+    // by their first word before anything else; comparing the stored spellings
+    // caselessly orders them as the folded keys would.
+    std::span<Rotation const> IndexFile::find(std::string_view query, bool prefix) const
+    {
+        auto const first = [this](Rotation rotation)
+        {
+            auto const ids = line(rotation.line);
+            if (rotation.offset >= ids.size())
+            {
+                corrupt("rotation out of range");
+            }
+            return spelling(ids[rotation.offset]);
+        };
+        auto const begin = std::partition_point(table.begin(), table.end(), [&](Rotation rotation)
+                                                { return ascii::compareCaseless(first(rotation), query) < 0; });
+        auto const end = std::partition_point(begin, table.end(), [&](Rotation rotation)
+                                              {
+                                                  auto const word = first(rotation);
+                                                  return prefix ? ascii::mismatchCaseless(word, query) == query.size()
+                                                                : ascii::compareCaseless(word, query) == 0; });
+        return {begin, end};
+    }
+
+}
@@ -0,0 +1,78 @@
+#ifndef INDEXFILE_HPP_
+#define INDEXFILE_HPP_
+
+#include "KwicIndex.hpp"
+#include "Rotations.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <span>
+#include <string_view>
+
+namespace text
+{
+
+    // A KWIC index on disk, laid out to be used straight from a read-only
+    // mapping. After a 64-byte header come, each padded to 8 bytes:
+    //
+    //   word offsets     uint64[words + 1] into the spellings
+    //   spellings        the words' bytes, back to back
+    //   line offsets     uint64[lines + 1] into the line words
+    //   line words       uint32[] word ids of every line
+    //   rotations        {uint32 line, uint32 offset}[] in kwic() order
+    //
+    // Integers are in the writer's byte order, which the header records along
+    // with a format version and a checksum of everything after it.
+    class IndexFile
+    {
+    public:
+        static constexpr std::uint32_t version = 1;
+
+        // Writes the lines and sorted rotations of `index`. Throws std::system_error.
+        static void write(KwicIndex const &index, std::filesystem::path const &path);
+
+        // Maps the file and checks its header and size, reading nothing else.
+        // Throws std::system_error if it cannot be mapped, std::runtime_error if
+        // it is not an index of this version and byte order.
+        explicit IndexFile(std::filesystem::path const &path);
+        IndexFile(IndexFile const &) = delete;
+        IndexFile &operator=(IndexFile const &) = delete;
+        ~IndexFile();
+
+        // Compares the checksum; touches every page.
+        bool verify() const;
+
+        std::size_t wordCount() const;
+        std::size_t lineCount() const;
+        std::string_view spelling(WordId id) const;
+        std::span<WordId const> line(std::uint32_t id) const;
+
+        // All rotations in kwic() order.
+        std::span<Rotation const> rotations() const;
+        // Rotations whose first word is `keyword`, ignoring case.
+        std::span<Rotation const> withKeyword(std::string_view keyword) const;
+        // Rotations whose first word starts with `prefix`, ignoring case.
+        std::span<Rotation const> withPrefix(std::string_view prefix) const;
+
+        // Writes the rotations like kwic() does. Throws std::runtime_error on an
+        // entry that points outside the file.
+        void print(std::span<Rotation const> rotations, std::ostream &out) const;
+
+    private:
+        std::span<Rotation const> find(std::string_view query, bool prefix) const;
+
+        void const *address{};
+        std::size_t size{};
+        std::span<std::uint64_t const> wordOffsets;
+        std::string_view spellings;
+        std::span<std::uint64_t const> lineOffsets;
+        std::span<WordId const> lineWords;
+        std::span<Rotation const> table;
+        std::uint64_t checksum{};
+    };
+
+}
+
+#endif
@@ -1,67 +1,46 @@
-#include "kwic.hpp"
-#include "word.hpp"
+#include "Kwic.hpp"
+#include "ExternalKwic.hpp"
+#include "KwicIndex.hpp"
+#include "KwicStages.hpp"
+#include "RotationWriter.hpp"
 
-#include <algorithm>
 #include <iostream>
-#include <iterator>
-#include <set>
-#include <sstream>
-#include <string>
-#include <vector>
 
 namespace text
 {
 
-    using Line = std::vector<Word>;
-
-    void kwic(std::istream &in, std::ostream &out)
+    namespace
     {
-        auto comparator = [](Line const &lhs, Line const &rhs)
-        {
-            return std::lexicographical_compare(
-                lhs.begin(), lhs.end(),
-                rhs.begin(), rhs.end());
-        };
-
-        std::set<Line, decltype(comparator)> allRotations(comparator);
-
-        std::string inputLine;
-        while (std::getline(in, inputLine))
+        void sequentialKwic(std::istream &in, std::ostream &out, StopWords const &stopWords)
         {
-            if (inputLine.empty())
+            KwicIndex index{stopWords};
+            index.add(in);
+            RotationWriter writer{out};
+            for (auto const rotation : index.all())
             {
-                continue; 
-            }
-
-            Line words;
-            std::istringstream lineStream(inputLine);
-            Word w;
-            while (lineStream >> w)
-            {
-                words.push_back(w);
+                writer.write(index.rotations(), rotation);
             }
+        }
+    }
 
-            if (words.empty())
-            {
-                continue; 
-            }
+    void kwic(std::istream &in, std::ostream &out)
+    {
+        sequentialKwic(in, out, StopWords{});
+    }
 
-            for (size_t i = 0; i < words.size(); ++i)
-            {
-                Line rotation = words;
-                std::rotate(rotation.begin(), rotation.begin() + i, rotation.end());
-                allRotations.insert(rotation);
-            }
+    void kwic(std::istream &in, std::ostream &out, KwicOptions const &options)
+    {
+        if (options.memoryBudget != 0)
+        {
+            externalKwic(in, out, options.memoryBudget, options.spillDirectory, options.stopWords);
+            return;
         }
-
-        for (auto const &line : allRotations)
+        if (options.workers <= 1)
         {
-            for (auto const &w : line)
-            {
-                out << w << ' ';   
-            }
-            out << '\n';
+            sequentialKwic(in, out, options.stopWords);
+            return;
         }
-            }
+        parallelKwic(in, out, options.workers, options.stopWords);
+    }
 
-        }
+}
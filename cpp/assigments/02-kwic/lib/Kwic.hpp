@@ -1,12 +1,30 @@
 #ifndef KWIC_HPP_
 #define KWIC_HPP_
 
+#include "StopWords.hpp"
+
+#include <cstddef>
+#include <filesystem>
 #include <iosfwd>
 
 namespace text
 {
 
+    struct KwicOptions
+    {
+        // Threads building the index; 1 runs the sequential algorithm.
+        unsigned workers{1};
+        // Heap bytes to work within by spilling sorted runs to disk; 0 keeps
+        // everything in memory. Takes precedence over workers.
+        std::size_t memoryBudget{};
+        // Where run files go; empty uses the system temporary directory.
+        std::filesystem::path spillDirectory{};
+        // Rotations starting with one of these words are never generated.
+        StopWords stopWords{};
+    };
+
     void kwic(std::istream &in, std::ostream &out);
+    void kwic(std::istream &in, std::ostream &out, KwicOptions const &options);
 
 }
 
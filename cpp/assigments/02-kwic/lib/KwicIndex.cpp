@@ -0,0 +1,231 @@
+#include "KwicIndex.hpp"
+#include "CaselessCompare.hpp"
+#include "KwicStages.hpp"
+#include "Tokenizer.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <utility>
+
+namespace text
+{
+
+    namespace
+    {
+        // Recent additions are merged into the sorted vector beyond this many or
+        // an eighth of its size, whichever is larger.
+        constexpr std::size_t minMerge = 1024;
+
+        std::string foldedKey(std::string_view word)
+        {
+            std::string key(word.size(), '\0');
+            std::transform(word.begin(), word.end(), key.begin(), ascii::foldCase);
+            return key;
+        }
+    }
+
+    bool KwicIndex::Order::operator()(Rotation lhs, Rotation rhs) const
+    {
+        return store->lessByKey(lhs, rhs);
+    }
+
+    // Rotations whose first word matches a query are contiguous, since rotations
+    // order by their first word before anything else.
+    bool KwicIndex::Order::operator()(Rotation lhs, Query const &rhs) const
+    {
+        auto const first = store->vocabulary().key(store->line(lhs.line)[lhs.offset]);
+        return first < rhs.key;
+    }
+
+    bool KwicIndex::Order::operator()(Query const &lhs, Rotation rhs) const
+    {
+        auto const first = store->vocabulary().key(store->line(rhs.line)[rhs.offset]);
+        return lhs.prefix ? first > lhs.key && !first.starts_with(lhs.key) : first > lhs.key;
+    }
+
+    KwicIndex::Iterator::Iterator(RotationStore const *store, Sorted::const_iterator sorted, Sorted::const_iterator sortedEnd, Recent::const_iterator recent, Recent::const_iterator recentEnd)
+        : store{store}, sorted{sorted}, sortedEnd{sortedEnd}, recent{recent}, recentEnd{recentEnd}
+    {
+    }
+
+    bool KwicIndex::Iterator::fromRecent() const
+    {
+        return sorted == sortedEnd || (recent != recentEnd && store->lessByKey(*recent, *sorted));
+    }
+
+    Rotation KwicIndex::Iterator::operator*() const
+    {
+        return fromRecent() ? *recent : *sorted;
+    }
+
+    KwicIndex::Iterator &KwicIndex::Iterator::operator++()
+    {
+        if (fromRecent())
+        {
+            ++recent;
+        }
+        else
+        {
+            ++sorted;
+        }
+        return *this;
+    }
+
+    KwicIndex::Iterator KwicIndex::Iterator::operator++(int)
+    {
+        Iterator const previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    bool KwicIndex::Iterator::operator==(Iterator const &other) const
+    {
+        return sorted == other.sorted && recent == other.recent;
+    }
+
+    KwicIndex::Range::Range(Iterator first, Iterator last, std::size_t count)
+        : first{first}, last{last}, count{count}
+    {
+    }
+
+    KwicIndex::Iterator KwicIndex::Range::begin() const
+    {
+        return first;
+    }
+
+    KwicIndex::Iterator KwicIndex::Range::end() const
+    {
+        return last;
+    }
+
+    std::size_t KwicIndex::Range::size() const
+    {
+        return count;
+    }
+
+    bool KwicIndex::Range::empty() const
+    {
+        return count == 0;
+    }
+
+    KwicIndex::KwicIndex()
+        : recent{Order{&store}}
+    {
+    }
+
+    KwicIndex::KwicIndex(StopWords stopWords)
+        : stopWords{std::move(stopWords)}, recent{Order{&store}}
+    {
+    }
+
+    std::size_t KwicIndex::addLine(std::string_view inputLine)
+    {
+        std::vector<Rotation> rotations;
+        text::addLine(inputLine, store, rotations, stopWords);
+
+        std::size_t added = 0;
+        for (auto const rotation : rotations)
+        {
+            if (!std::binary_search(sorted.begin(), sorted.end(), rotation, Order{&store}) && recent.insert(rotation).second)
+            {
+                ++added;
+            }
+        }
+        if (recent.size() > std::max(minMerge, sorted.size() / 8))
+        {
+            mergeRecent();
+        }
+        return added;
+    }
+
+    void KwicIndex::add(std::istream &in)
+    {
+        std::vector<Rotation> batch;
+        LineReader lines{in};
+        for (std::string_view inputLine; lines.next(inputLine);)
+        {
+            text::addLine(inputLine, store, batch, stopWords);
+        }
+
+        // Fresh ranks cover old and new words alike, so the batch sorts and
+        // merges by integer compares.
+        store.rank();
+        sortRotations(store, batch);
+        if (!sorted.empty() || !recent.empty())
+        {
+            std::erase_if(batch, [this](Rotation rotation)
+                          { return contains(rotation); });
+        }
+
+        Sorted merged;
+        merged.reserve(sorted.size() + batch.size());
+        std::merge(sorted.begin(), sorted.end(), batch.begin(), batch.end(), std::back_inserter(merged), [this](Rotation lhs, Rotation rhs)
+                   { return store.less(lhs, rhs); });
+        sorted = std::move(merged);
+    }
+
+    std::size_t KwicIndex::size() const
+    {
+        return sorted.size() + recent.size();
+    }
+
+    KwicIndex::Range KwicIndex::all() const
+    {
+        return Range{Iterator{&store, sorted.begin(), sorted.end(), recent.begin(), recent.end()},
+                     Iterator{&store, sorted.end(), sorted.end(), recent.end(), recent.end()},
+                     size()};
+    }
+
+    KwicIndex::Range KwicIndex::withKeyword(std::string_view keyword) const
+    {
+        return find(Order::Query{foldedKey(keyword), false});
+    }
+
+    KwicIndex::Range KwicIndex::withPrefix(std::string_view prefix) const
+    {
+        return find(Order::Query{foldedKey(prefix), true});
+    }
+
+    void KwicIndex::print(Rotation rotation, std::ostream &out) const
+    {
+        store.print(rotation, out);
+    }
+
+    std::string KwicIndex::context(Rotation rotation) const
+    {
+        std::string result;
+        store.append(rotation, result);
+        return result;
+    }
+
+    RotationStore const &KwicIndex::rotations() const
+    {
+        return store;
+    }
+
+    bool KwicIndex::contains(Rotation rotation) const
+    {
+        return std::binary_search(sorted.begin(), sorted.end(), rotation, Order{&store}) || recent.contains(rotation);
+    }
+
+    void KwicIndex::mergeRecent()
+    {
+        Sorted merged;
+        merged.reserve(sorted.size() + recent.size());
+        std::merge(sorted.begin(), sorted.end(), recent.begin(), recent.end(), std::back_inserter(merged), Order{&store});
+        sorted = std::move(merged);
+        recent.clear();
+    }
+
+    KwicIndex::Range KwicIndex::find(Order::Query const &query) const
+    {
+        auto const [sortedFirst, sortedLast] = std::equal_range(sorted.begin(), sorted.end(), query, Order{&store});
+        auto const [recentFirst, recentLast] = recent.equal_range(query);
+        auto const count = static_cast<std::size_t>(sortedLast - sortedFirst) + static_cast<std::size_t>(std::distance(recentFirst, recentLast));
+        return Range{Iterator{&store, sortedFirst, sortedLast, recentFirst, recentLast},
+                     Iterator{&store, sortedLast, sortedLast, recentLast, recentLast},
+                     count};
+    }
+
+}
@@ -0,0 +1,129 @@
+#ifndef KWICINDEX_HPP_
+#define KWICINDEX_HPP_
+
+#include "Rotations.hpp"
+#include "StopWords.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <iterator>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace text
+{
+
+    // The sorted rotations of a growing text. Lines can be added at any time;
+    // a rotation equal to one already indexed is dropped, as kwic() does.
+    // Queries see every line added so far and cost O(log n + k) for k results.
+    //
+    // Rotations live in a sorted vector plus a set of recent additions; the set
+    // is merged into the vector once it reaches an eighth of its size, so an
+    // added line costs amortized O(log n) per rotation and never a re-sort.
+    class KwicIndex
+    {
+        // Orders rotations, and compares their first word with a query.
+        struct Order
+        {
+            using is_transparent = void;
+
+            struct Query
+            {
+                std::string key;
+                bool prefix;
+            };
+
+            bool operator()(Rotation lhs, Rotation rhs) const;
+            bool operator()(Rotation lhs, Query const &rhs) const;
+            bool operator()(Query const &lhs, Rotation rhs) const;
+
+            RotationStore const *store;
+        };
+
+        using Sorted = std::vector<Rotation>;
+        using Recent = std::set<Rotation, Order>;
+
+    public:
+        // Visits the rotations of a range of the vector and of the set in order.
+        class Iterator
+        {
+        public:
+            using value_type = Rotation;
+            using difference_type = std::ptrdiff_t;
+            using iterator_category = std::forward_iterator_tag;
+
+            Iterator() = default;
+            Iterator(RotationStore const *store, Sorted::const_iterator sorted, Sorted::const_iterator sortedEnd, Recent::const_iterator recent, Recent::const_iterator recentEnd);
+
+            Rotation operator*() const;
+            Iterator &operator++();
+            Iterator operator++(int);
+            bool operator==(Iterator const &other) const;
+
+        private:
+            bool fromRecent() const;
+
+            RotationStore const *store{};
+            Sorted::const_iterator sorted{};
+            Sorted::const_iterator sortedEnd{};
+            Recent::const_iterator recent{};
+            Recent::const_iterator recentEnd{};
+        };
+
+        class Range
+        {
+        public:
+            Range(Iterator first, Iterator last, std::size_t count);
+
+            Iterator begin() const;
+            Iterator end() const;
+            std::size_t size() const;
+            bool empty() const;
+
+        private:
+            Iterator first;
+            Iterator last;
+            std::size_t count;
+        };
+
+        KwicIndex();
+        // An index without the rotations that start with one of `stopWords`.
+        explicit KwicIndex(StopWords stopWords);
+        // The set's ordering refers to the store of this very object.
+        KwicIndex(KwicIndex const &) = delete;
+        KwicIndex &operator=(KwicIndex const &) = delete;
+
+        // Adds one line and returns how many of its rotations were new.
+        std::size_t addLine(std::string_view inputLine);
+        // Adds all lines of `in` as one sorted batch; much faster than addLine()
+        // per line when building an index from a whole text.
+        void add(std::istream &in);
+
+        std::size_t size() const;
+        Range all() const;
+        // Rotations whose first word is `keyword`, ignoring case.
+        Range withKeyword(std::string_view keyword) const;
+        // Rotations whose first word starts with `prefix`, ignoring case.
+        Range withPrefix(std::string_view prefix) const;
+
+        // Prints the rotation like kwic() does, without the line break.
+        void print(Rotation rotation, std::ostream &out) const;
+        std::string context(Rotation rotation) const;
+        RotationStore const &rotations() const;
+
+    private:
+        bool contains(Rotation rotation) const;
+        void mergeRecent();
+        Range find(Order::Query const &query) const;
+
+        StopWords stopWords;
+        RotationStore store;
+        Sorted sorted;
+        Recent recent;
+    };
+
+}
+
+#endif
@@ -0,0 +1,402 @@
+#include "KwicStages.hpp"
+#include "MultikeySort.hpp"
+#include "Tokenizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace text
+{
+
+    namespace
+    {
+        // One worker's share of the input: the blocks it took, in input order.
+        struct Part
+        {
+            RotationStore store;
+            std::vector<Rotation> rotations;
+            // The input block of every stored line; of equal rotations in
+            // different parts, the one from the earliest block is kept.
+            std::vector<std::uint32_t> blocks;
+        };
+
+        // Line-aligned input blocks on their way from the reader to the workers,
+        // numbered in input order. Holds a few blocks at most, so the input is
+        // never in memory as a whole.
+        class BlockQueue
+        {
+        public:
+            explicit BlockQueue(std::size_t capacity)
+                : capacity{capacity}
+            {
+            }
+
+            // Waits for room; false once cancelled.
+            bool push(std::string block)
+            {
+                std::unique_lock lock{mutex};
+                changed.wait(lock, [this]
+                             { return cancelled || blocks.size() < capacity; });
+                if (cancelled)
+                {
+                    return false;
+                }
+                blocks.push(std::move(block));
+                changed.notify_all();
+                return true;
+            }
+
+            // Waits for the next block; false once finished and drained, or cancelled.
+            bool pop(std::string &block, std::uint32_t &index)
+            {
+                std::unique_lock lock{mutex};
+                changed.wait(lock, [this]
+                             { return cancelled || finished || !blocks.empty(); });
+                if (cancelled || blocks.empty())
+                {
+                    return false;
+                }
+                block = std::move(blocks.front());
+                blocks.pop();
+                index = popped++;
+                changed.notify_all();
+                return true;
+            }
+
+            // No more blocks will be pushed.
+            void finish()
+            {
+                std::lock_guard lock{mutex};
+                finished = true;
+                changed.notify_all();
+            }
+
+            // Drops the queued blocks and makes every wait return false.
+            void cancel()
+            {
+                std::lock_guard lock{mutex};
+                cancelled = true;
+                changed.notify_all();
+            }
+
+        private:
+            std::size_t capacity;
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::queue<std::string> blocks;
+            std::uint32_t popped{};
+            bool finished{};
+            bool cancelled{};
+        };
+
+        struct Element
+        {
+            std::size_t part;
+            Rotation rotation;
+        };
+
+        // Calls f(i) for every i below count on up to `threads` threads. The
+        // first exception stops handing out work and is rethrown here once all
+        // threads have finished.
+        template <typename F>
+        void forEachParallel(std::size_t count, unsigned threads, F f)
+        {
+            std::atomic<std::size_t> next{0};
+            std::mutex failureMutex;
+            std::exception_ptr failure;
+            {
+                std::vector<std::jthread> pool;
+                for (unsigned t = 0; t < std::min<std::size_t>(threads, count); ++t)
+                {
+                    pool.emplace_back([&]
+                                      {
+                                          try
+                                          {
+                                              for (std::size_t i = next++; i < count; i = next++)
+                                              {
+                                                  f(i);
+                                              }
+                                          }
+                                          catch (...)
+                                          {
+                                              next = count;
+                                              std::lock_guard lock{failureMutex};
+                                              if (!failure)
+                                              {
+                                                  failure = std::current_exception();
+                                              }
+                                          } });
+                }
+            }
+            if (failure)
+            {
+                std::rethrow_exception(failure);
+            }
+        }
+
+        void tokenize(Part &part, std::string_view block, std::uint32_t index, StopWords const &stopWords)
+        {
+            LineReader lines{block};
+            for (std::string_view inputLine; lines.next(inputLine);)
+            {
+                addLine(inputLine, part.store, part.rotations, stopWords);
+            }
+            part.blocks.resize(part.store.lineCount(), index);
+        }
+
+        // Reads the input on one thread while `workers` threads tokenize it,
+        // each into its own part.
+        std::vector<Part> tokenizeParallel(std::istream &in, unsigned workers, StopWords const &stopWords, std::size_t blockSize)
+        {
+            std::vector<Part> parts(workers);
+            BlockQueue queue{2 * std::size_t{workers}};
+            forEachParallel(workers + 1, workers + 1, [&](std::size_t task)
+                            {
+                                try
+                                {
+                                    if (task == 0)
+                                    {
+                                        LineReader lines{in, blockSize};
+                                        for (std::string_view block; lines.nextLines(block, blockSize);)
+                                        {
+                                            if (!queue.push(std::string{block}))
+                                            {
+                                                return;
+                                            }
+                                        }
+                                        queue.finish();
+                                        return;
+                                    }
+                                    std::string block;
+                                    for (std::uint32_t index{}; queue.pop(block, index);)
+                                    {
+                                        tokenize(parts[task - 1], block, index, stopWords);
+                                    }
+                                }
+                                catch (...)
+                                {
+                                    queue.cancel();
+                                    throw;
+                                } });
+            return parts;
+        }
+
+        // Gives every word the rank of its key among the keys of all parts.
+        void rankGlobally(std::vector<Part> &parts, unsigned workers)
+        {
+            std::vector<std::string_view> keys;
+            for (auto const &part : parts)
+            {
+                auto const &vocabulary = part.store.vocabulary();
+                for (WordId id = 0; id < vocabulary.size(); ++id)
+                {
+                    keys.push_back(vocabulary.key(id));
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+            forEachParallel(parts.size(), workers, [&](std::size_t i)
+                            {
+                                auto &vocabulary = parts[i].store.vocabulary();
+                                std::vector<std::uint32_t> ranks(vocabulary.size());
+                                for (WordId id = 0; id < vocabulary.size(); ++id)
+                                {
+                                    auto const found = std::lower_bound(keys.begin(), keys.end(), vocabulary.key(id));
+                                    ranks[id] = static_cast<std::uint32_t>(found - keys.begin());
+                                }
+                                vocabulary.setRanks(std::move(ranks)); });
+        }
+
+        bool less(std::vector<Part> const &parts, Element lhs, Element rhs)
+        {
+            return parts[lhs.part].store.less(lhs.rotation, parts[rhs.part].store, rhs.rotation);
+        }
+
+        // Sampled rotations that cut the key space into ranges of similar size.
+        std::vector<Element> splitters(std::vector<Part> const &parts, std::size_t ranges)
+        {
+            std::vector<Element> samples;
+            for (std::size_t p = 0; p < parts.size(); ++p)
+            {
+                auto const &rotations = parts[p].rotations;
+                for (std::size_t s = 1; s < ranges && !rotations.empty(); ++s)
+                {
+                    samples.push_back(Element{p, rotations[s * rotations.size() / ranges]});
+                }
+            }
+            std::sort(samples.begin(), samples.end(), [&](Element lhs, Element rhs)
+                      { return less(parts, lhs, rhs); });
+
+            std::vector<Element> result;
+            for (std::size_t s = 1; s < ranges && !samples.empty(); ++s)
+            {
+                result.push_back(samples[s * samples.size() / ranges]);
+            }
+            return result;
+        }
+
+        std::uint32_t blockOf(std::vector<Part> const &parts, Element element)
+        {
+            return parts[element.part].blocks[element.rotation.line];
+        }
+
+        // K-way merge of one key range of every part through a min-heap of
+        // the parts' next rotations. Equal rotations meet in the same range and
+        // leave the heap in input order, so the one from the earliest block is kept.
+        std::string mergeRange(std::vector<Part> const &parts, std::vector<std::vector<std::size_t>> const &bounds, std::size_t range)
+        {
+            auto const later = [&parts](Element lhs, Element rhs)
+            {
+                return less(parts, rhs, lhs) || (!less(parts, lhs, rhs) && blockOf(parts, lhs) > blockOf(parts, rhs));
+            };
+            std::vector<std::size_t> cursor(parts.size());
+            std::priority_queue<Element, std::vector<Element>, decltype(later)> heads{later};
+            for (std::size_t p = 0; p < parts.size(); ++p)
+            {
+                cursor[p] = bounds[p][range];
+                if (cursor[p] != bounds[p][range + 1])
+                {
+                    heads.push(Element{p, parts[p].rotations[cursor[p]]});
+                }
+            }
+
+            std::string output;
+            bool any = false;
+            Element last{};
+            while (!heads.empty())
+            {
+                Element const smallest = heads.top();
+                heads.pop();
+                auto const p = smallest.part;
+                if (++cursor[p] != bounds[p][range + 1])
+                {
+                    heads.push(Element{p, parts[p].rotations[cursor[p]]});
+                }
+                if (any && !less(parts, last, smallest))
+                {
+                    continue;
+                }
+                parts[p].store.append(smallest.rotation, output);
+                output += '\n';
+                last = smallest;
+                any = true;
+            }
+            return output;
+        }
+    }
+
+    WordIds internWords(std::string_view inputLine, Vocabulary &vocabulary)
+    {
+        WordIds words;
+        WordScanner scanner{inputLine};
+        for (auto word = scanner.next(); !word.empty(); word = scanner.next())
+        {
+            words.push_back(vocabulary.intern(word));
+        }
+        return words;
+    }
+
+    void addLine(std::string_view inputLine, RotationStore &store, std::vector<Rotation> &rotations)
+    {
+        addLine(inputLine, store, rotations, StopWords{});
+    }
+
+    void addLine(std::string_view inputLine, RotationStore &store, std::vector<Rotation> &rotations, StopWords const &stopWords)
+    {
+        WordIds words = internWords(inputLine, store.vocabulary());
+        if (words.empty())
+        {
+            return;
+        }
+
+        auto const size = static_cast<std::uint32_t>(words.size());
+        auto const id = store.addLine(std::move(words));
+        if (stopWords.empty())
+        {
+            for (std::uint32_t i = 0; i < size; ++i)
+            {
+                rotations.push_back(Rotation{id, i});
+            }
+            return;
+        }
+        auto const &ids = store.line(id);
+        for (std::uint32_t i = 0; i < size; ++i)
+        {
+            if (!stopWords.contains(store.vocabulary().spelling(ids[i])))
+            {
+                rotations.push_back(Rotation{id, i});
+            }
+        }
+    }
+
+    void sortRotations(RotationStore const &store, std::vector<Rotation> &rotations)
+    {
+        // Never compares a shared prefix twice, unlike a comparison sort.
+        multikeySortRotations(store, rotations);
+    }
+
+    void parallelKwic(std::istream &in, std::ostream &out, unsigned workers, StopWords const &stopWords, std::size_t blockSize)
+    {
+        workers = std::max(workers, 1u);
+        auto parts = tokenizeParallel(in, workers, stopWords, blockSize);
+        rankGlobally(parts, workers);
+        forEachParallel(parts.size(), workers, [&](std::size_t i)
+                        { sortRotations(parts[i].store, parts[i].rotations); });
+
+        // More ranges than workers keep the threads busy and the buffered output small.
+        auto const cuts = splitters(parts, 4 * std::size_t{workers});
+        std::size_t const ranges = cuts.size() + 1;
+        std::vector<std::vector<std::size_t>> bounds(parts.size());
+        for (std::size_t p = 0; p < parts.size(); ++p)
+        {
+            auto const &rotations = parts[p].rotations;
+            bounds[p].push_back(0);
+            for (auto const cut : cuts)
+            {
+                auto const found = std::lower_bound(rotations.begin(), rotations.end(), cut, [&](Rotation rotation, Element splitter)
+                                                    { return less(parts, Element{p, rotation}, splitter); });
+                bounds[p].push_back(static_cast<std::size_t>(found - rotations.begin()));
+            }
+            bounds[p].push_back(rotations.size());
+        }
+
+        // Ranges are merged in parallel and written in order as they complete.
+        std::vector<std::promise<std::string>> merged(ranges);
+        std::vector<std::future<std::string>> outputs;
+        for (auto &promise : merged)
+        {
+            outputs.push_back(promise.get_future());
+        }
+        std::jthread merging{[&]
+                             { forEachParallel(ranges, workers, [&](std::size_t range)
+                                               {
+                                                   // Failures surface through output.get() on the caller's thread.
+                                                   try
+                                                   {
+                                                       merged[range].set_value(mergeRange(parts, bounds, range));
+                                                   }
+                                                   catch (...)
+                                                   {
+                                                       merged[range].set_exception(std::current_exception());
+                                                   } }); }};
+        for (auto &output : outputs)
+        {
+            auto const text = output.get();
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+    }
+
+}
@@ -0,0 +1,39 @@
+#ifndef KWICSTAGES_HPP_
+#define KWICSTAGES_HPP_
+
+#include "Rotations.hpp"
+#include "StopWords.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace text
+{
+
+    // Interns the words of one input line, in order.
+    WordIds internWords(std::string_view inputLine, Vocabulary &vocabulary);
+
+    // Interns the words of one input line and appends all of its rotations.
+    void addLine(std::string_view inputLine, RotationStore &store, std::vector<Rotation> &rotations);
+    // Same, but skips the rotations that would start with a stop word; the
+    // line itself is stored whole, since the other rotations print all of it.
+    void addLine(std::string_view inputLine, RotationStore &store, std::vector<Rotation> &rotations, StopWords const &stopWords);
+
+    // Orders the rotations and drops every one equal to an earlier one, which
+    // keeps the rotation std::set::insert would have kept. Needs a ranked store.
+    void sortRotations(RotationStore const &store, std::vector<Rotation> &rotations);
+
+    constexpr std::size_t parallelBlockSize = 256 * 1024;
+
+    // kwic() on `workers` threads: the input is read in line-aligned blocks of
+    // about `blockSize` bytes that the workers tokenize as they arrive, each
+    // worker's rotations are sorted in parallel, then all are merged by key
+    // range in parallel. Byte-identical output.
+    void parallelKwic(std::istream &in, std::ostream &out, unsigned workers, StopWords const &stopWords, std::size_t blockSize = parallelBlockSize);
+
+}
+
+#endif
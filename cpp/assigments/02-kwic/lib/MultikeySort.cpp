@@ -0,0 +1,77 @@
+#include "MultikeySort.hpp"
+
+#include <limits>
+
+namespace text
+{
+
+    namespace
+    {
+        // A rotation as a run of the flattened symbols, and where it came from.
+        struct Item
+        {
+            std::uint32_t position;
+            std::uint32_t length;
+            std::uint32_t index;
+        };
+
+        constexpr std::uint32_t dropped = std::numeric_limits<std::uint32_t>::max();
+    }
+
+    void multikeySortRotations(RotationStore const &store, std::vector<Rotation> &rotations)
+    {
+        // Every line that has rotations is laid out twice, less its last word,
+        // as ranks + 1, so a rotation's symbols are contiguous.
+        std::vector<std::uint32_t> lineStarts(store.lineCount(), dropped);
+        std::vector<std::uint32_t> symbols;
+        auto const &vocabulary = store.vocabulary();
+        std::vector<Item> items;
+        items.reserve(rotations.size());
+        for (std::uint32_t i = 0; i < rotations.size(); ++i)
+        {
+            auto const rotation = rotations[i];
+            WordIds const &words = store.line(rotation.line);
+            if (lineStarts[rotation.line] == dropped)
+            {
+                lineStarts[rotation.line] = static_cast<std::uint32_t>(symbols.size());
+                for (std::size_t w = 0; w < 2 * words.size() - 1; ++w)
+                {
+                    symbols.push_back(vocabulary.rankOf(words[w % words.size()]) + 1);
+                }
+            }
+            items.push_back(Item{lineStarts[rotation.line] + rotation.offset, static_cast<std::uint32_t>(words.size()), i});
+        }
+
+        auto const symbol = [&symbols](Item const &item, std::size_t depth)
+        {
+            return depth < item.length ? symbols[item.position + depth] : 0u;
+        };
+        // Of equal rotations, the first one added stays.
+        auto const keepFirst = [](std::span<Item> equal)
+        {
+            auto const first = std::min_element(equal.begin(), equal.end(), [](Item const &lhs, Item const &rhs)
+                                                { return lhs.index < rhs.index; })
+                                   ->index;
+            for (auto &item : equal)
+            {
+                if (item.index != first)
+                {
+                    item.index = dropped;
+                }
+            }
+        };
+        multikeySort(std::span<Item>{items}, symbol, keepFirst);
+
+        std::vector<Rotation> sorted;
+        sorted.reserve(items.size());
+        for (auto const &item : items)
+        {
+            if (item.index != dropped)
+            {
+                sorted.push_back(rotations[item.index]);
+            }
+        }
+        rotations = std::move(sorted);
+    }
+
+}
@@ -0,0 +1,140 @@
+#ifndef MULTIKEYSORT_HPP_
+#define MULTIKEYSORT_HPP_
+
+#include "Rotations.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace text
+{
+
+    namespace multikey
+    {
+        // Below this many items insertion sort beats another partitioning round.
+        constexpr std::size_t insertionThreshold = 12;
+
+        // First depth from `depth` on where the sequences differ, and their order there.
+        template <typename Item, typename Symbol>
+        int compareFrom(Item const &lhs, Item const &rhs, std::size_t depth, Symbol const &symbol)
+        {
+            for (;; ++depth)
+            {
+                auto const left = symbol(lhs, depth);
+                auto const right = symbol(rhs, depth);
+                if (left != right)
+                {
+                    return left < right ? -1 : 1;
+                }
+                if (left == 0)
+                {
+                    return 0;
+                }
+            }
+        }
+
+        template <typename Item, typename Symbol, typename OnEqual>
+        void insertionSort(std::span<Item> items, std::size_t depth, Symbol const &symbol, OnEqual &onEqual)
+        {
+            for (std::size_t i = 1; i < items.size(); ++i)
+            {
+                for (std::size_t j = i; j > 0 && compareFrom(items[j], items[j - 1], depth, symbol) < 0; --j)
+                {
+                    std::swap(items[j], items[j - 1]);
+                }
+            }
+            for (std::size_t first = 0, last = 1; first < items.size(); first = last++)
+            {
+                while (last < items.size() && compareFrom(items[first], items[last], depth, symbol) == 0)
+                {
+                    ++last;
+                }
+                if (last - first > 1)
+                {
+                    onEqual(items.subspan(first, last - first));
+                }
+            }
+        }
+    }
+
+    // Multikey quicksort (Bentley and Sedgewick) of items that are sequences of
+    // symbols. symbol(item, depth) is the item's symbol at that position: 0 past
+    // its end, positive before. Each round partitions by one symbol and only the
+    // items equal there advance to the next position, so a shared prefix is never
+    // compared twice. onEqual(span) sees every run of two or more identical items.
+    template <typename Item, typename Symbol, typename OnEqual>
+    void multikeySort(std::span<Item> items, Symbol const &symbol, OnEqual onEqual, std::size_t depth = 0)
+    {
+        while (items.size() > 1)
+        {
+            if (items.size() < multikey::insertionThreshold)
+            {
+                multikey::insertionSort(items, depth, symbol, onEqual);
+                return;
+            }
+
+            auto const first = symbol(items.front(), depth);
+            auto const middle = symbol(items[items.size() / 2], depth);
+            auto const last = symbol(items.back(), depth);
+            auto const pivot = std::max(std::min(first, middle), std::min(std::max(first, middle), last));
+
+            std::size_t less = 0;
+            std::size_t greater = items.size();
+            for (std::size_t i = 0; i < greater;)
+            {
+                auto const current = symbol(items[i], depth);
+                if (current < pivot)
+                {
+                    std::swap(items[less++], items[i++]);
+                }
+                else if (current > pivot)
+                {
+                    std::swap(items[i], items[--greater]);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+
+            // Items equal past their end are finished. Of the parts left, only the
+            // largest stays in this loop; the others hold at most half the items
+            // each, so the recursion is at most log2(n) deep.
+            std::span<Item> const parts[] = {items.first(less), items.subspan(less, greater - less), items.subspan(greater)};
+            bool const equalDone = pivot == 0;
+            if (equalDone && parts[1].size() > 1)
+            {
+                onEqual(parts[1]);
+            }
+            std::size_t largest = parts[0].size() >= parts[2].size() ? 0 : 2;
+            if (!equalDone && parts[1].size() > parts[largest].size())
+            {
+                largest = 1;
+            }
+            for (std::size_t part = 0; part < 3; ++part)
+            {
+                if (part != largest && !(part == 1 && equalDone))
+                {
+                    multikeySort(parts[part], symbol, onEqual, part == 1 ? depth + 1 : depth);
+                }
+            }
+            items = parts[largest];
+            if (largest == 1)
+            {
+                ++depth;
+            }
+        }
+    }
+
+    // Sorts rotations into kwic() order and keeps only the first of equal ones,
+    // like sortRotations(), by a multikey quicksort over word ranks followed by a
+    // linear pass that drops the duplicates it found. Needs a ranked store.
+    void multikeySortRotations(RotationStore const &store, std::vector<Rotation> &rotations);
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include "RotationWriter.hpp"
+
+#include <cstring>
+#include <ostream>
+
+namespace text
+{
+
+    RotationWriter::RotationWriter(std::ostream &out, std::size_t bufferSize)
+        : out{out}, buffer(bufferSize == 0 ? 1 : bufferSize)
+    {
+    }
+
+    RotationWriter::~RotationWriter()
+    {
+        // A stream that throws on failure must not escape the destructor.
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void RotationWriter::write(RotationStore const &store, Rotation rotation)
+    {
+        WordIds const &ids = store.line(rotation.line);
+        auto const &vocabulary = store.vocabulary();
+        for (std::size_t i = rotation.offset; i < ids.size(); ++i)
+        {
+            append(vocabulary.spelling(ids[i]));
+        }
+        for (std::size_t i = 0; i < rotation.offset; ++i)
+        {
+            append(vocabulary.spelling(ids[i]));
+        }
+        put('\n');
+    }
+
+    void RotationWriter::write(std::span<std::string_view const> words)
+    {
+        for (auto const word : words)
+        {
+            append(word);
+        }
+        put('\n');
+    }
+
+    void RotationWriter::flush()
+    {
+        out.write(buffer.data(), static_cast<std::streamsize>(used));
+        used = 0;
+    }
+
+    // The word and its trailing blank.
+    void RotationWriter::append(std::string_view word)
+    {
+        if (buffer.size() - used <= word.size())
+        {
+            flush();
+            if (buffer.size() <= word.size())
+            {
+                out.write(word.data(), static_cast<std::streamsize>(word.size()));
+                put(' ');
+                return;
+            }
+        }
+        std::memcpy(buffer.data() + used, word.data(), word.size());
+        used += word.size();
+        buffer[used++] = ' ';
+    }
+
+    void RotationWriter::put(char c)
+    {
+        if (used == buffer.size())
+        {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+}
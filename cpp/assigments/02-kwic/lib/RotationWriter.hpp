@@ -0,0 +1,43 @@
+#ifndef ROTATIONWRITER_HPP_
+#define ROTATIONWRITER_HPP_
+
+#include "Rotations.hpp"
+
+#include <cstddef>
+#include <iosfwd>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace text
+{
+
+    // Renders KWIC lines (every word followed by a blank, then '\n') into a large
+    // buffer and hands it to the stream in few big writes instead of a stream
+    // call per word. Flushes when full, on flush() and on destruction.
+    class RotationWriter
+    {
+    public:
+        static constexpr std::size_t defaultBufferSize = 256 * 1024;
+
+        explicit RotationWriter(std::ostream &out, std::size_t bufferSize = defaultBufferSize);
+        RotationWriter(RotationWriter const &) = delete;
+        RotationWriter &operator=(RotationWriter const &) = delete;
+        ~RotationWriter();
+
+        void write(RotationStore const &store, Rotation rotation);
+        void write(std::span<std::string_view const> words);
+        void flush();
+
+    private:
+        void append(std::string_view word);
+        void put(char c);
+
+        std::ostream &out;
+        std::vector<char> buffer;
+        std::size_t used{};
+    };
+
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "Rotations.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <utility>
+
+namespace text
+{
+
+    std::uint32_t RotationStore::addLine(Line const &line)
+    {
+        WordIds ids;
+        ids.reserve(line.size());
+        for (auto const &word : line)
+        {
+            ids.push_back(words.intern(word.spelling()));
+        }
+        return addLine(std::move(ids));
+    }
+
+    std::uint32_t RotationStore::addLine(WordIds ids)
+    {
+        storedWords += ids.capacity();
+        lines.push_back(std::move(ids));
+        return static_cast<std::uint32_t>(lines.size() - 1);
+    }
+
+    WordIds const &RotationStore::line(std::uint32_t id) const
+    {
+        return lines[id];
+    }
+
+    std::size_t RotationStore::lineCount() const
+    {
+        return lines.size();
+    }
+
+    Vocabulary &RotationStore::vocabulary()
+    {
+        return words;
+    }
+
+    Vocabulary const &RotationStore::vocabulary() const
+    {
+        return words;
+    }
+
+    std::size_t RotationStore::memoryUsage() const
+    {
+        return words.memoryUsage() + lines.capacity() * sizeof(WordIds) + storedWords * sizeof(WordId);
+    }
+
+    void RotationStore::rank()
+    {
+        words.rank();
+    }
+
+    bool RotationStore::less(Rotation lhs, Rotation rhs) const
+    {
+        return less(lhs, *this, rhs);
+    }
+
+    bool RotationStore::less(Rotation lhs, RotationStore const &other, Rotation rhs) const
+    {
+        WordIds const &left = lines[lhs.line];
+        WordIds const &right = other.lines[rhs.line];
+        std::size_t l = lhs.offset;
+        std::size_t r = rhs.offset;
+        for (std::size_t remaining = std::min(left.size(), right.size()); remaining != 0; --remaining)
+        {
+            auto const leftRank = words.rankOf(left[l]);
+            auto const rightRank = other.words.rankOf(right[r]);
+            if (leftRank != rightRank)
+            {
+                return leftRank < rightRank;
+            }
+            l = l + 1 == left.size() ? 0 : l + 1;
+            r = r + 1 == right.size() ? 0 : r + 1;
+        }
+        return left.size() < right.size();
+    }
+
+    bool RotationStore::lessByKey(Rotation lhs, Rotation rhs) const
+    {
+        WordIds const &left = lines[lhs.line];
+        WordIds const &right = lines[rhs.line];
+        std::size_t l = lhs.offset;
+        std::size_t r = rhs.offset;
+        for (std::size_t remaining = std::min(left.size(), right.size()); remaining != 0; --remaining)
+        {
+            if (left[l] != right[r])
+            {
+                auto const leftKey = words.key(left[l]);
+                auto const rightKey = words.key(right[r]);
+                if (leftKey != rightKey)
+                {
+                    return leftKey < rightKey;
+                }
+            }
+            l = l + 1 == left.size() ? 0 : l + 1;
+            r = r + 1 == right.size() ? 0 : r + 1;
+        }
+        return left.size() < right.size();
+    }
+
+    void RotationStore::append(Rotation rotation, std::string &out) const
+    {
+        WordIds const &ids = lines[rotation.line];
+        for (std::size_t i = rotation.offset; i < ids.size(); ++i)
+        {
+            out += words.spelling(ids[i]);
+            out += ' ';
+        }
+        for (std::size_t i = 0; i < rotation.offset; ++i)
+        {
+            out += words.spelling(ids[i]);
+            out += ' ';
+        }
+    }
+
+    void RotationStore::print(Rotation rotation, std::ostream &out) const
+    {
+        WordIds const &ids = lines[rotation.line];
+        for (std::size_t i = rotation.offset; i < ids.size(); ++i)
+        {
+            out << words.spelling(ids[i]) << ' ';
+        }
+        for (std::size_t i = 0; i < rotation.offset; ++i)
+        {
+            out << words.spelling(ids[i]) << ' ';
+        }
+    }
+
+}
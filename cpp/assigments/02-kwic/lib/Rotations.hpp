@@ -0,0 +1,66 @@
+#ifndef ROTATIONS_HPP_
+#define ROTATIONS_HPP_
+
+#include "Vocabulary.hpp"
+#include "Word.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace text
+{
+
+    using Line = std::vector<Word>;
+    using WordIds = std::vector<WordId>;
+
+    // The words of a stored line starting at `offset` and wrapping around to
+    // the beginning, i.e. one KWIC rotation without a copy of its words.
+    struct Rotation
+    {
+        std::uint32_t line;
+        std::uint32_t offset;
+    };
+
+    // Owns exactly one copy of every line, as interned word ids; rotations refer
+    // into it, so n words cost O(n) storage however many rotations are indexed.
+    class RotationStore
+    {
+    public:
+        std::uint32_t addLine(Line const &words);
+        std::uint32_t addLine(WordIds words);
+
+        WordIds const &line(std::uint32_t id) const;
+        std::size_t lineCount() const;
+        Vocabulary &vocabulary();
+        Vocabulary const &vocabulary() const;
+        // Approximate heap bytes held by the lines and the vocabulary.
+        std::size_t memoryUsage() const;
+
+        // Ranks the vocabulary; required after adding lines and before less().
+        void rank();
+
+        // Lexicographic order of the circular word sequences, as for rotated
+        // Lines, but comparing integer ranks instead of strings.
+        bool less(Rotation lhs, Rotation rhs) const;
+        // Same, for a rotation of another store ranked consistently with this one.
+        bool less(Rotation lhs, RotationStore const &other, Rotation rhs) const;
+        // The same order from the case-folded spellings; slower, but needs no
+        // ranks and so stays valid while words are added.
+        bool lessByKey(Rotation lhs, Rotation rhs) const;
+
+        // Prints every word of the rotation in its original spelling, followed by a blank.
+        void print(Rotation rotation, std::ostream &out) const;
+        void append(Rotation rotation, std::string &out) const;
+
+    private:
+        Vocabulary words;
+        std::vector<WordIds> lines;
+        std::size_t storedWords{};
+    };
+
+}
+
+#endif
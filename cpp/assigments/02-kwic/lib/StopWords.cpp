@@ -0,0 +1,106 @@
+#include "StopWords.hpp"
+#include "Tokenizer.hpp"
+
+#include <algorithm>
+#include <istream>
+
+namespace text
+{
+
+    StopWords StopWords::english()
+    {
+        StopWords result;
+        result.builtin = true;
+        return result;
+    }
+
+    StopWords StopWords::load(std::istream &in)
+    {
+        StopWords result;
+        LineReader lines{in};
+        for (std::string_view line; lines.next(line);)
+        {
+            WordScanner scanner{line};
+            for (auto word = scanner.next(); !word.empty(); word = scanner.next())
+            {
+                result.add(word);
+            }
+        }
+        return result;
+    }
+
+    void StopWords::add(std::string_view word)
+    {
+        if (word.empty() || contains(word))
+        {
+            return;
+        }
+        // At most half full, so probe sequences stay short.
+        if (2 * (words.size() + 1) > slots.size())
+        {
+            grow();
+        }
+        auto &folded = words.emplace_back(word);
+        std::transform(folded.begin(), folded.end(), folded.begin(), ascii::foldCase);
+
+        std::size_t const mask = slots.size() - 1;
+        std::size_t i = stopwords::hash(folded, 0) & mask;
+        while (slots[i] != 0)
+        {
+            i = (i + 1) & mask;
+        }
+        slots[i] = static_cast<std::uint32_t>(words.size());
+    }
+
+    void StopWords::add(StopWords const &other)
+    {
+        builtin = builtin || other.builtin;
+        for (auto const &word : other.words)
+        {
+            add(word);
+        }
+    }
+
+    bool StopWords::contains(std::string_view word) const
+    {
+        if (builtin && isEnglishStopWord(word))
+        {
+            return true;
+        }
+        if (words.empty())
+        {
+            return false;
+        }
+        std::size_t const mask = slots.size() - 1;
+        for (std::size_t i = stopwords::hash(word, 0) & mask; slots[i] != 0; i = (i + 1) & mask)
+        {
+            auto const &candidate = words[slots[i] - 1];
+            if (candidate.size() == word.size() && ascii::mismatchCaseless(candidate, word) == word.size())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool StopWords::empty() const
+    {
+        return !builtin && words.empty();
+    }
+
+    void StopWords::grow()
+    {
+        slots.assign(std::max<std::size_t>(16, 2 * slots.size()), 0);
+        std::size_t const mask = slots.size() - 1;
+        for (std::uint32_t index = 0; index < words.size(); ++index)
+        {
+            std::size_t i = stopwords::hash(words[index], 0) & mask;
+            while (slots[i] != 0)
+            {
+                i = (i + 1) & mask;
+            }
+            slots[i] = index + 1;
+        }
+    }
+
+}
@@ -0,0 +1,131 @@
+#ifndef STOPWORDS_HPP_
+#define STOPWORDS_HPP_
+
+#include "CaselessCompare.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace text
+{
+
+    namespace stopwords
+    {
+        // FNV-1a over the case-folded bytes, so lookups need no folded copy.
+        constexpr std::uint32_t hash(std::string_view word, std::uint32_t seed)
+        {
+            std::uint32_t result = 2166136261u ^ seed;
+            for (char const c : word)
+            {
+                result = (result ^ static_cast<unsigned char>(ascii::foldCase(c))) * 16777619u;
+            }
+            return result;
+        }
+
+        // Common English function words, lower case.
+        inline constexpr std::array<std::string_view, 48> english{
+            "a", "about", "after", "all", "an", "and", "are", "as", "at", "be", "been", "but",
+            "by", "for", "from", "had", "has", "have", "he", "her", "his", "i", "if", "in",
+            "into", "is", "it", "its", "not", "of", "on", "or", "she", "so", "that", "the",
+            "their", "them", "there", "they", "this", "to", "was", "we", "were", "which", "with", "you"};
+
+        // A collision-free table of `english`: slot (hash * multiplier) >> 24 of
+        // every word holds its index plus one. The seed is searched at compile time.
+        struct PerfectTable
+        {
+            std::uint32_t seed{};
+            std::size_t longest{};
+            std::array<std::uint8_t, 256> slots{};
+        };
+
+        constexpr std::size_t slot(std::string_view word, std::uint32_t seed)
+        {
+            return (hash(word, seed) * 0x9E3779B9u) >> 24;
+        }
+
+        constexpr PerfectTable perfectTable()
+        {
+            for (std::uint32_t seed = 0;; ++seed)
+            {
+                PerfectTable table{seed};
+                bool collision = false;
+                for (std::size_t i = 0; i < english.size() && !collision; ++i)
+                {
+                    auto &entry = table.slots[slot(english[i], seed)];
+                    collision = entry != 0;
+                    entry = static_cast<std::uint8_t>(i + 1);
+                    table.longest = std::max(table.longest, english[i].size());
+                }
+                if (!collision)
+                {
+                    return table;
+                }
+            }
+        }
+
+        inline constexpr PerfectTable table = perfectTable();
+    }
+
+    // Whether `word` is in the built-in English list, ignoring case: one hash
+    // and at most one string comparison.
+    constexpr bool isEnglishStopWord(std::string_view word)
+    {
+        if (word.empty() || word.size() > stopwords::table.longest)
+        {
+            return false;
+        }
+        auto const entry = stopwords::table.slots[stopwords::slot(word, stopwords::table.seed)];
+        if (entry == 0)
+        {
+            return false;
+        }
+        auto const candidate = stopwords::english[entry - 1];
+        if (candidate.size() != word.size())
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < word.size(); ++i)
+        {
+            if (ascii::foldCase(word[i]) != candidate[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Words no KWIC rotation may start with, compared ignoring case: optionally
+    // the built-in English list, plus any words added at runtime, which go into
+    // an open-addressing table with linear probing. Empty by default.
+    class StopWords
+    {
+    public:
+        StopWords() = default;
+        static StopWords english();
+        // Adds every word of `in`, split as input lines are.
+        static StopWords load(std::istream &in);
+
+        void add(std::string_view word);
+        // Adds the words of the other list, built-in ones included.
+        void add(StopWords const &other);
+        bool contains(std::string_view word) const;
+        bool empty() const;
+
+    private:
+        void grow();
+
+        bool builtin{};
+        // Folded words; a slot holds an index into them plus one, 0 if free.
+        std::vector<std::string> words;
+        std::vector<std::uint32_t> slots;
+    };
+
+}
+
+#endif
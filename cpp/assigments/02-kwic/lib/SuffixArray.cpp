@@ -0,0 +1,233 @@
+#include "SuffixArray.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace text
+{
+
+    namespace
+    {
+        constexpr std::uint32_t empty = std::numeric_limits<std::uint32_t>::max();
+
+        class InducedSort
+        {
+        public:
+            InducedSort(std::span<std::uint32_t const> text, std::span<std::uint32_t> suffixes, std::uint32_t alphabetSize)
+                : text{text}, suffixes{suffixes}, smaller(text.size()), counts(alphabetSize), buckets(alphabetSize)
+            {
+                // A suffix is S-type if it is smaller than the next one, L-type otherwise.
+                std::size_t const size = text.size();
+                smaller[size - 1] = true;
+                for (std::size_t i = size - 1; i-- > 0;)
+                {
+                    smaller[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && smaller[i + 1]);
+                }
+                for (auto const symbol : text)
+                {
+                    ++counts[symbol];
+                }
+            }
+
+            void run()
+            {
+                std::size_t const size = text.size();
+
+                // Sort the LMS substrings by inducing from their unsorted positions.
+                std::fill(suffixes.begin(), suffixes.end(), empty);
+                bucketEnds();
+                for (std::size_t i = 1; i < size; ++i)
+                {
+                    if (leftmostSmaller(i))
+                    {
+                        suffixes[--buckets[text[i]]] = static_cast<std::uint32_t>(i);
+                    }
+                }
+                induce();
+
+                // Name the sorted LMS substrings; equal substrings share a name.
+                std::size_t lmsCount = 0;
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    if (leftmostSmaller(suffixes[i]))
+                    {
+                        suffixes[lmsCount++] = suffixes[i];
+                    }
+                }
+                std::fill(suffixes.begin() + static_cast<std::ptrdiff_t>(lmsCount), suffixes.end(), empty);
+                std::uint32_t names = 0;
+                std::uint32_t previous = empty;
+                for (std::size_t i = 0; i < lmsCount; ++i)
+                {
+                    std::uint32_t const position = suffixes[i];
+                    if (previous == empty || !equalLmsSubstrings(previous, position))
+                    {
+                        ++names;
+                        previous = position;
+                    }
+                    // LMS positions are at least two apart, so halving keeps them distinct.
+                    suffixes[lmsCount + position / 2] = names - 1;
+                }
+                for (std::size_t i = size, j = size; i-- > lmsCount;)
+                {
+                    if (suffixes[i] != empty)
+                    {
+                        suffixes[--j] = suffixes[i];
+                    }
+                }
+
+                // Sort the LMS suffixes: directly if all names differ, else recursively.
+                auto const reduced = suffixes.subspan(size - lmsCount);
+                auto const reducedSuffixes = suffixes.first(lmsCount);
+                if (names < lmsCount)
+                {
+                    InducedSort{reduced, reducedSuffixes, names}.run();
+                }
+                else
+                {
+                    for (std::size_t i = 0; i < lmsCount; ++i)
+                    {
+                        reducedSuffixes[reduced[i]] = static_cast<std::uint32_t>(i);
+                    }
+                }
+
+                // Induce the order of all suffixes from the sorted LMS suffixes.
+                for (std::size_t i = 1, j = 0; i < size; ++i)
+                {
+                    if (leftmostSmaller(i))
+                    {
+                        reduced[j++] = static_cast<std::uint32_t>(i);
+                    }
+                }
+                for (auto &suffix : reducedSuffixes)
+                {
+                    suffix = reduced[suffix];
+                }
+                std::fill(suffixes.begin() + static_cast<std::ptrdiff_t>(lmsCount), suffixes.end(), empty);
+                bucketEnds();
+                for (std::size_t i = lmsCount; i-- > 0;)
+                {
+                    std::uint32_t const position = suffixes[i];
+                    suffixes[i] = empty;
+                    suffixes[--buckets[text[position]]] = position;
+                }
+                induce();
+            }
+
+        private:
+            bool leftmostSmaller(std::size_t i) const
+            {
+                return i != empty && i > 0 && smaller[i] && !smaller[i - 1];
+            }
+
+            bool equalLmsSubstrings(std::size_t lhs, std::size_t rhs) const
+            {
+                for (std::size_t d = 0;; ++d)
+                {
+                    if (text[lhs + d] != text[rhs + d] || smaller[lhs + d] != smaller[rhs + d])
+                    {
+                        return false;
+                    }
+                    if (d > 0 && (leftmostSmaller(lhs + d) || leftmostSmaller(rhs + d)))
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            void bucketStarts()
+            {
+                std::uint32_t sum = 0;
+                for (std::size_t c = 0; c < counts.size(); ++c)
+                {
+                    buckets[c] = sum;
+                    sum += counts[c];
+                }
+            }
+
+            void bucketEnds()
+            {
+                std::uint32_t sum = 0;
+                for (std::size_t c = 0; c < counts.size(); ++c)
+                {
+                    sum += counts[c];
+                    buckets[c] = sum;
+                }
+            }
+
+            // Places L-type suffixes left to right, then S-type ones right to left.
+            void induce()
+            {
+                bucketStarts();
+                for (std::size_t i = 0; i < suffixes.size(); ++i)
+                {
+                    std::uint32_t const position = suffixes[i];
+                    if (position != empty && position > 0 && !smaller[position - 1])
+                    {
+                        suffixes[buckets[text[position - 1]]++] = position - 1;
+                    }
+                }
+                bucketEnds();
+                for (std::size_t i = suffixes.size(); i-- > 0;)
+                {
+                    std::uint32_t const position = suffixes[i];
+                    if (position != empty && position > 0 && smaller[position - 1])
+                    {
+                        suffixes[--buckets[text[position - 1]]] = position - 1;
+                    }
+                }
+            }
+
+            std::span<std::uint32_t const> text;
+            std::span<std::uint32_t> suffixes;
+            std::vector<bool> smaller;
+            std::vector<std::uint32_t> counts;
+            std::vector<std::uint32_t> buckets;
+        };
+    }
+
+    std::vector<std::uint32_t> suffixArray(std::span<std::uint32_t const> text, std::uint32_t alphabetSize)
+    {
+        std::vector<std::uint32_t> suffixes(text.size());
+        if (text.size() == 1)
+        {
+            return suffixes;
+        }
+        InducedSort{text, suffixes, alphabetSize}.run();
+        return suffixes;
+    }
+
+    std::vector<std::uint32_t> lcpArray(std::span<std::uint32_t const> text, std::span<std::uint32_t const> suffixes)
+    {
+        std::size_t const size = text.size();
+        std::vector<std::uint32_t> rank(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            rank[suffixes[i]] = static_cast<std::uint32_t>(i);
+        }
+
+        std::vector<std::uint32_t> lcp(size);
+        std::uint32_t common = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            if (rank[i] == 0)
+            {
+                common = 0;
+                continue;
+            }
+            std::size_t const previous = suffixes[rank[i] - 1];
+            while (i + common < size && previous + common < size && text[i + common] == text[previous + common])
+            {
+                ++common;
+            }
+            lcp[rank[i]] = common;
+            if (common > 0)
+            {
+                --common;
+            }
+        }
+        return lcp;
+    }
+
+}
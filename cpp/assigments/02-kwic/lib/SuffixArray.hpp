@@ -0,0 +1,22 @@
+#ifndef SUFFIXARRAY_HPP_
+#define SUFFIXARRAY_HPP_
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace text
+{
+
+    // The start positions of all suffixes of `text` in lexicographic order, built
+    // in linear time by induced sorting (SA-IS). Symbols must lie below
+    // `alphabetSize`, and the text must end with a 0 that occurs nowhere else.
+    std::vector<std::uint32_t> suffixArray(std::span<std::uint32_t const> text, std::uint32_t alphabetSize);
+
+    // lcp[i] is the length of the longest common prefix of the suffixes at
+    // suffixes[i - 1] and suffixes[i]; lcp[0] is 0. Linear time (Kasai et al.).
+    std::vector<std::uint32_t> lcpArray(std::span<std::uint32_t const> text, std::span<std::uint32_t const> suffixes);
+
+}
+
+#endif
@@ -0,0 +1,206 @@
+#include "SuffixIndex.hpp"
+#include "CaselessCompare.hpp"
+#include "KwicStages.hpp"
+#include "RotationWriter.hpp"
+#include "SuffixArray.hpp"
+#include "Tokenizer.hpp"
+
+#include <algorithm>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace text
+{
+
+    namespace
+    {
+        // Symbols below the word ranks.
+        constexpr std::uint32_t sentinel = 0;
+        constexpr std::uint32_t separator = 1;
+        constexpr std::uint32_t firstWord = 2;
+
+        // A rotation at its position in suffix order.
+        struct Entry
+        {
+            Rotation rotation;
+            std::uint32_t length;
+            // Suffix-order index of the first rotation sharing this one's words.
+            std::uint32_t blockStart;
+        };
+    }
+
+    SuffixIndex::SuffixIndex(std::istream &in)
+    {
+        LineReader reader{in};
+        for (std::string_view inputLine; reader.next(inputLine);)
+        {
+            if (auto words = internWords(inputLine, lines.vocabulary()); !words.empty())
+            {
+                lines.addLine(std::move(words));
+            }
+        }
+        lines.rank();
+
+        auto const &vocabulary = lines.vocabulary();
+        for (WordId id = 0; id < vocabulary.size(); ++id)
+        {
+            auto const rank = vocabulary.rankOf(id);
+            keysByRank.resize(std::max<std::size_t>(keysByRank.size(), rank + 1));
+            keysByRank[rank] = vocabulary.key(id);
+        }
+
+        for (std::uint32_t line = 0; line < lines.lineCount(); ++line)
+        {
+            WordIds const &words = lines.line(line);
+            lineStarts.push_back(static_cast<std::uint32_t>(text.size()));
+            for (std::size_t i = 0; i < 2 * words.size() - 1; ++i)
+            {
+                text.push_back(firstWord + vocabulary.rankOf(words[i % words.size()]));
+            }
+            text.push_back(separator);
+        }
+        text.push_back(sentinel);
+
+        auto const alphabetSize = firstWord + static_cast<std::uint32_t>(keysByRank.size());
+        std::vector<Entry> entries;
+        {
+            auto const suffixes = suffixArray(text, alphabetSize);
+            auto const lcp = lcpArray(text, suffixes);
+
+            // Keep the suffixes that start a rotation; the LCP between two kept
+            // ones is the minimum over the suffixes in between.
+            std::vector<std::uint32_t> common;
+            auto between = std::numeric_limits<std::uint32_t>::max();
+            for (std::size_t i = 0; i < suffixes.size(); ++i)
+            {
+                between = std::min(between, lcp[i]);
+                auto const position = suffixes[i];
+                if (text[position] < firstWord)
+                {
+                    continue;
+                }
+                auto const line = static_cast<std::uint32_t>(std::upper_bound(lineStarts.begin(), lineStarts.end(), position) - lineStarts.begin() - 1);
+                if (position - lineStarts[line] >= lines.line(line).size())
+                {
+                    continue;
+                }
+                auto const length = static_cast<std::uint32_t>(lines.line(line).size());
+                entries.push_back(Entry{Rotation{line, position - lineStarts[line]}, length, 0});
+                common.push_back(entries.size() == 1 ? 0 : between);
+                between = std::numeric_limits<std::uint32_t>::max();
+            }
+
+            // A rotation's block starts after the last LCP shorter than it. The
+            // stack holds the candidates: indices whose LCP is below all later ones.
+            std::vector<std::uint32_t> stack;
+            for (std::uint32_t i = 0; i < entries.size(); ++i)
+            {
+                while (!stack.empty() && common[stack.back()] >= common[i])
+                {
+                    stack.pop_back();
+                }
+                stack.push_back(i);
+                auto const found = std::partition_point(stack.begin(), stack.end(), [&](std::uint32_t j)
+                                                        { return common[j] < entries[i].length; });
+                entries[i].blockStart = *(found - 1);
+            }
+        }
+
+        // Equal rotations end up next to each other, the first added one first.
+        std::sort(entries.begin(), entries.end(), [](Entry const &lhs, Entry const &rhs)
+                  { return std::tie(lhs.blockStart, lhs.length, lhs.rotation.line, lhs.rotation.offset) <
+                           std::tie(rhs.blockStart, rhs.length, rhs.rotation.line, rhs.rotation.offset); });
+        for (std::size_t i = 0; i < entries.size(); ++i)
+        {
+            if (i == 0 || entries[i].blockStart != entries[i - 1].blockStart || entries[i].length != entries[i - 1].length)
+            {
+                order.push_back(entries[i].rotation);
+            }
+        }
+    }
+
+    std::span<Rotation const> SuffixIndex::rotations() const
+    {
+        return order;
+    }
+
+    std::span<Rotation const> SuffixIndex::find(std::string_view phrase) const
+    {
+        std::vector<std::uint32_t> symbols;
+        WordScanner words{phrase};
+        for (auto word = words.next(); !word.empty(); word = words.next())
+        {
+            std::string key{word};
+            std::transform(key.begin(), key.end(), key.begin(), ascii::foldCase);
+            auto const found = std::lower_bound(keysByRank.begin(), keysByRank.end(), key);
+            if (found == keysByRank.end() || *found != key)
+            {
+                return {};
+            }
+            symbols.push_back(firstWord + static_cast<std::uint32_t>(found - keysByRank.begin()));
+        }
+
+        // The first index for which `after` holds, searching between exclusive bounds.
+        auto bound = [&](auto after)
+        {
+            std::size_t low = 0;
+            std::size_t high = order.size() + 1;
+            std::size_t lowMatched = 0;
+            std::size_t highMatched = 0;
+            while (high - low > 1)
+            {
+                std::size_t const middle = low + (high - low) / 2;
+                std::size_t matched = std::min(lowMatched, highMatched);
+                if (after(compare(order[middle - 1], symbols, matched)))
+                {
+                    high = middle;
+                    highMatched = matched;
+                }
+                else
+                {
+                    low = middle;
+                    lowMatched = matched;
+                }
+            }
+            return low;
+        };
+        std::size_t const first = bound([](int sign)
+                                        { return sign >= 0; });
+        std::size_t const last = bound([](int sign)
+                                       { return sign > 0; });
+        return std::span<Rotation const>{order}.subspan(first, last - first);
+    }
+
+    int SuffixIndex::compare(Rotation rotation, std::span<std::uint32_t const> phrase, std::size_t &matched) const
+    {
+        std::size_t const length = lines.line(rotation.line).size();
+        std::uint32_t const *const words = text.data() + lineStarts[rotation.line] + rotation.offset;
+        for (; matched < std::min(length, phrase.size()); ++matched)
+        {
+            if (words[matched] != phrase[matched])
+            {
+                return words[matched] < phrase[matched] ? -1 : 1;
+            }
+        }
+        return matched == phrase.size() ? 0 : -1;
+    }
+
+    void SuffixIndex::print(std::ostream &out) const
+    {
+        RotationWriter writer{out};
+        for (auto const rotation : order)
+        {
+            writer.write(lines, rotation);
+        }
+    }
+
+    RotationStore const &SuffixIndex::store() const
+    {
+        return lines;
+    }
+
+}
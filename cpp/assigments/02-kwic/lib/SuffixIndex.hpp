@@ -0,0 +1,53 @@
+#ifndef SUFFIXINDEX_HPP_
+#define SUFFIXINDEX_HPP_
+
+#include "Rotations.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace text
+{
+
+    // A static KWIC index over a whole text, built from a word-level suffix array.
+    //
+    // Every line w0..wn-1 is laid out as w0..wn-1 w0..wn-2 followed by a
+    // separator, so each rotation is a contiguous run of n symbols (word ranks)
+    // at the start of a suffix. A suffix array (SA-IS) and its LCP array order
+    // the suffixes. Only one fix-up is needed: kwic() puts a rotation before
+    // every longer rotation it is a prefix of. The LCP array gives each
+    // rotation the first suffix that shares its n words, and sorting by that
+    // position, then by length, yields the kwic() order. Phrase lookups are
+    // binary searches that skip the words already matched at both bounds.
+    class SuffixIndex
+    {
+    public:
+        explicit SuffixIndex(std::istream &in);
+
+        // All rotations in kwic() order, without duplicates.
+        std::span<Rotation const> rotations() const;
+        // Rotations starting with the words of `phrase`, ignoring case, in kwic() order.
+        std::span<Rotation const> find(std::string_view phrase) const;
+        // Writes what kwic() writes.
+        void print(std::ostream &out) const;
+        RotationStore const &store() const;
+
+    private:
+        // Negative if the rotation orders before every rotation starting with
+        // the phrase, zero if it starts with it, positive otherwise. Words
+        // before `matched` are known to agree and advance it.
+        int compare(Rotation rotation, std::span<std::uint32_t const> phrase, std::size_t &matched) const;
+
+        RotationStore lines;
+        std::vector<std::uint32_t> text;
+        std::vector<std::uint32_t> lineStarts;
+        std::vector<Rotation> order;
+        std::vector<std::string_view> keysByRank;
+    };
+
+}
+
+#endif
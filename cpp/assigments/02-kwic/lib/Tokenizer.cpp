@@ -0,0 +1,102 @@
+#include "Tokenizer.hpp"
+
+#include <array>
+#include <cctype>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENIZER_X86 1
+#else
+#define TOKENIZER_X86 0
+#endif
+
+namespace text
+{
+
+    namespace
+    {
+        // std::isalpha for every byte, as Word::read() applies it.
+        struct Letters
+        {
+            Letters()
+            {
+                for (unsigned c = 0; c < table.size(); ++c)
+                {
+                    table[c] = std::isalpha(static_cast<int>(c)) != 0;
+                    asciiOnly = asciiOnly && table[c] == ((c | 0x20) - 'a' < 26);
+                }
+            }
+
+            std::array<bool, 256> table{};
+            // True in the "C" locale; only then may the vector kernels classify.
+            bool asciiOnly{true};
+        };
+
+        Letters const &letters()
+        {
+            static Letters const letters;
+            return letters;
+        }
+
+        char const *findInTable(char const *from, char const *limit, bool letter)
+        {
+            auto const &table = letters().table;
+            while (from != limit && table[static_cast<unsigned char>(*from)] != letter)
+            {
+                ++from;
+            }
+            return from;
+        }
+
+#if TOKENIZER_X86
+        // One bit per byte of the block, set for 'A'..'Z' and 'a'..'z'.
+        [[gnu::target("sse2")]] unsigned letterMask(char const *block)
+        {
+            __m128i const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(block));
+            __m128i const offset = _mm_sub_epi8(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+            __m128i const letter = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(25)), offset);
+            return static_cast<unsigned>(_mm_movemask_epi8(letter));
+        }
+
+        // The first byte from `from` whose class is `letter`, 16 bytes at a time.
+        char const *findClass(char const *from, char const *limit, bool letter)
+        {
+            while (limit - from >= 16)
+            {
+                unsigned const mask = letter ? letterMask(from) : ~letterMask(from) & 0xFFFF;
+                if (mask != 0)
+                {
+                    return from + __builtin_ctz(mask);
+                }
+                from += 16;
+            }
+            return findInTable(from, limit, letter);
+        }
+#endif
+
+        char const *find(char const *from, char const *limit, bool letter)
+        {
+#if TOKENIZER_X86
+            if (letters().asciiOnly)
+            {
+                return findClass(from, limit, letter);
+            }
+#endif
+            return findInTable(from, limit, letter);
+        }
+    }
+
+    WordScanner::WordScanner(std::string_view text)
+        : cursor{text.data()}, limit{text.data() + text.size()}
+    {
+    }
+
+    std::string_view WordScanner::next()
+    {
+        char const *const first = find(cursor, limit, true);
+        cursor = find(first, limit, false);
+        return std::string_view{first, static_cast<std::size_t>(cursor - first)};
+    }
+
+}
@@ -0,0 +1,32 @@
+#ifndef TOKENIZER_HPP_
+#define TOKENIZER_HPP_
+
+#include "LineReader.hpp"
+
+#include <string_view>
+
+namespace text
+{
+
+    // Splits text into the words Word::read() extracts: maximal runs of
+    // characters std::isalpha accepts, with everything in between skipped.
+    // Works on a buffer instead of a stream and yields views into it.
+    class WordScanner
+    {
+    public:
+        explicit WordScanner(std::string_view text);
+
+        // The next word, or an empty view after the last one.
+        std::string_view next();
+
+    private:
+        char const *cursor;
+        char const *limit;
+    };
+
+    // The block line reader shared with the calculator.
+    using io::LineReader;
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "Vocabulary.hpp"
+
+#include "CaselessCompare.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace text
+{
+
+    namespace
+    {
+        constexpr std::size_t blockSize = 64 * 1024;
+    }
+
+    WordId Vocabulary::intern(std::string_view word)
+    {
+        if (auto const found = index.find(word); found != index.end())
+        {
+            return found->second;
+        }
+
+        char *const spelling = allocate(2 * word.size());
+        char *const key = spelling + word.size();
+        std::copy(word.begin(), word.end(), spelling);
+        std::transform(word.begin(), word.end(), key, ascii::foldCase);
+
+        auto const id = static_cast<WordId>(entries.size());
+        entries.push_back(Entry{{spelling, word.size()}, {key, word.size()}});
+        index.emplace(entries.back().spelling, id);
+        return id;
+    }
+
+    std::string_view Vocabulary::spelling(WordId id) const
+    {
+        return entries[id].spelling;
+    }
+
+    std::string_view Vocabulary::key(WordId id) const
+    {
+        return entries[id].key;
+    }
+
+    std::size_t Vocabulary::size() const
+    {
+        return entries.size();
+    }
+
+    std::size_t Vocabulary::memoryUsage() const
+    {
+        // An index node holds the key, the id, the chaining pointer and the cached hash.
+        constexpr std::size_t node = sizeof(std::pair<std::string_view const, WordId>) + sizeof(void *) + sizeof(std::size_t);
+        // rank() needs the ranks and as much again while sorting the ids.
+        return reserved + entries.capacity() * (sizeof(Entry) + 2 * sizeof(std::uint32_t)) +
+               index.size() * node + index.bucket_count() * sizeof(void *);
+    }
+
+    void Vocabulary::rank()
+    {
+        std::vector<WordId> order(entries.size());
+        std::iota(order.begin(), order.end(), WordId{});
+        std::sort(order.begin(), order.end(), [this](WordId lhs, WordId rhs)
+                  { return entries[lhs].key < entries[rhs].key; });
+
+        ranks.resize(entries.size());
+        std::uint32_t rank{};
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            if (i != 0 && entries[order[i - 1]].key != entries[order[i]].key)
+            {
+                ++rank;
+            }
+            ranks[order[i]] = rank;
+        }
+    }
+
+    void Vocabulary::setRanks(std::vector<std::uint32_t> ranks)
+    {
+        this->ranks = std::move(ranks);
+    }
+
+    std::uint32_t Vocabulary::rankOf(WordId id) const
+    {
+        return ranks[id];
+    }
+
+    char *Vocabulary::allocate(std::size_t size)
+    {
+        if (size > available)
+        {
+            // Oversized words get a block of their own; the current one stays in use.
+            if (size > blockSize / 4)
+            {
+                reserved += size;
+                return blocks.emplace_back(std::make_unique_for_overwrite<char[]>(size)).get();
+            }
+            free = blocks.emplace_back(std::make_unique_for_overwrite<char[]>(blockSize)).get();
+            available = blockSize;
+            reserved += blockSize;
+        }
+        char *const memory = free;
+        free += size;
+        available -= size;
+        return memory;
+    }
+
+}
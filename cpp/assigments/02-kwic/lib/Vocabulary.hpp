@@ -0,0 +1,58 @@
+#ifndef VOCABULARY_HPP_
+#define VOCABULARY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace text
+{
+
+    using WordId = std::uint32_t;
+
+    // Interns words: every distinct spelling is stored once in an arena, next
+    // to its case-folded key, and is referred to by a dense WordId from then on.
+    class Vocabulary
+    {
+    public:
+        WordId intern(std::string_view word);
+
+        std::string_view spelling(WordId id) const;
+        // The lower-case form Word compares by.
+        std::string_view key(WordId id) const;
+        std::size_t size() const;
+        // Approximate heap bytes held, for callers working to a memory budget.
+        std::size_t memoryUsage() const;
+
+        // Numbers all words in case-insensitive order; spellings with equal keys
+        // share a rank. Comparing ranks then orders like comparing Words.
+        void rank();
+        // Adopts ranks computed elsewhere, e.g. over the keys of several
+        // vocabularies so their rotations can be compared with each other.
+        void setRanks(std::vector<std::uint32_t> ranks);
+        std::uint32_t rankOf(WordId id) const;
+
+    private:
+        struct Entry
+        {
+            std::string_view spelling;
+            std::string_view key;
+        };
+
+        char *allocate(std::size_t size);
+
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char *free{};
+        std::size_t available{};
+        std::size_t reserved{};
+        std::vector<Entry> entries;
+        std::vector<std::uint32_t> ranks;
+        std::unordered_map<std::string_view, WordId> index;
+    };
+
+}
+
+#endif
@@ -1,8 +1,10 @@
 
-#include "word.hpp"
+#include "Word.hpp"
+
+#include "CaselessCompare.hpp"
 
-#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <istream>
 #include <ostream>
 #include <stdexcept>
@@ -10,9 +12,13 @@
 namespace text 
 {
 
-Word::Word() : value{"default"} {}
+static_assert(sizeof(Word) == 32);
+
+Word::Word() {
+  assign("default");
+}
 
-Word::Word(std::string const& word) : value{word} {
+Word::Word(std::string const& word) {
   if (word.empty()) {
     throw std::invalid_argument("Word cannot be empty");
   }
@@ -22,10 +28,87 @@ Word::Word(std::string const& word) : value{word} {
       throw std::invalid_argument("Word can only contain alphabetic characters");
     }
   }
+  assign(word);
+}
+
+Word::Word(Word const& other) {
+  assign(other.spelling());
+}
+
+Word::Word(Word&& other) noexcept
+    : prefix{other.prefix}, length{other.length} {
+  std::memcpy(storage, other.storage, sizeof storage);
+  other.prefix = 0;
+  other.length = 0;
+}
+
+Word& Word::operator=(Word const& other) {
+  if (this != &other) {
+    assign(other.spelling());
+  }
+  return *this;
+}
+
+Word& Word::operator=(Word&& other) noexcept {
+  if (this != &other) {
+    release();
+    prefix = other.prefix;
+    length = other.length;
+    std::memcpy(storage, other.storage, sizeof storage);
+    other.prefix = 0;
+    other.length = 0;
+  }
+  return *this;
+}
+
+Word::~Word() {
+  release();
 }
 
 void Word::print(std::ostream& out) const {
-  out << value;
+  out << spelling();
+}
+
+std::string_view Word::spelling() const {
+  return {data(), length};
+}
+
+void Word::assign(std::string_view word) {
+  char* target = storage;
+  if (word.size() > inlineCapacity) {
+    target = new char[word.size()];
+  }
+  release();
+  if (target != storage) {
+    std::memcpy(storage, &target, sizeof target);
+  }
+  std::memcpy(target, word.data(), word.size());
+  length = static_cast<std::uint32_t>(word.size());
+
+  prefix = 0;
+  for (std::size_t i = 0; i < 8 && i < word.size(); ++i) {
+    prefix |= std::uint64_t{static_cast<unsigned char>(ascii::foldCase(word[i]))} << (56 - 8 * i);
+  }
+}
+
+void Word::release() {
+  if (!isInline()) {
+    delete[] const_cast<char*>(data());
+  }
+  length = 0;
+}
+
+char const* Word::data() const {
+  if (isInline()) {
+    return storage;
+  }
+  char* heap;
+  std::memcpy(&heap, storage, sizeof heap);
+  return heap;
+}
+
+bool Word::isInline() const {
+  return length <= inlineCapacity;
 }
 
 void Word::read(std::istream& in) {
@@ -48,42 +131,26 @@ void Word::read(std::istream& in) {
     newWord += c;
   }
   
-  value = newWord;
+  assign(newWord);
 }
 
-char Word::toLower(char c) {
-  return std::tolower(static_cast<unsigned char>(c));
-}
-
-int Word::compareCaseInsensitive(std::string const& lhs, std::string const& rhs) {
-  auto lhsIt = lhs.begin();
-  auto rhsIt = rhs.begin();
-  
-  while (lhsIt != lhs.end() && rhsIt != rhs.end()) {
-    char lhsChar = toLower(*lhsIt);
-    char rhsChar = toLower(*rhsIt);
-    
-    if (lhsChar < rhsChar) {
-      return -1;
-    } else if (lhsChar > rhsChar) {
-      return 1;
-    }
-    
-    ++lhsIt;
-    ++rhsIt;
+// Words hold letters only, so the ASCII kernel orders them exactly like
+// comparing std::tolower'ed characters did. Most pairs differ within the
+// first eight letters and are settled by the prefixes alone.
+int Word::compareCaseInsensitive(Word const& lhs, Word const& rhs) {
+  if (lhs.prefix != rhs.prefix) {
+    return lhs.prefix < rhs.prefix ? -1 : 1;
   }
-  
-  if (lhsIt == lhs.end() && rhsIt == rhs.end()) {
-    return 0; 
-  } else if (lhsIt == lhs.end()) {
-    return -1; 
-  } else {
-    return 1;
+  // Equal prefixes of words this short mean equal words; otherwise both have
+  // at least eight letters, as the zero padding would differ from a letter.
+  if (lhs.length <= 8 && rhs.length <= 8) {
+    return 0;
   }
+  return ascii::compareCaseless(lhs.spelling().substr(8), rhs.spelling().substr(8));
 }
 
 bool Word::operator==(Word const& other) const {
-  return compareCaseInsensitive(value, other.value) == 0;
+  return compareCaseInsensitive(*this, other) == 0;
 }
 
 bool Word::operator!=(Word const& other) const {
@@ -91,19 +158,19 @@ bool Word::operator!=(Word const& other) const {
 }
 
 bool Word::operator<(Word const& other) const {
-  return compareCaseInsensitive(value, other.value) < 0;
+  return compareCaseInsensitive(*this, other) < 0;
 }
 
 bool Word::operator<=(Word const& other) const {
-  return compareCaseInsensitive(value, other.value) <= 0;
+  return compareCaseInsensitive(*this, other) <= 0;
 }
 
 bool Word::operator>(Word const& other) const {
-  return compareCaseInsensitive(value, other.value) > 0;
+  return compareCaseInsensitive(*this, other) > 0;
 }
 
 bool Word::operator>=(Word const& other) const {
-  return compareCaseInsensitive(value, other.value) >= 0;
+  return compareCaseInsensitive(*this, other) >= 0;
 }
 
 std::ostream& operator<<(std::ostream& out, Word const& word) {
@@ -1,8 +1,11 @@
 #ifndef WORD_HPP_
 #define WORD_HPP_
 
+#include <cstddef>
+#include <cstdint>
 #include <iosfwd>
 #include <string>
+#include <string_view>
 
 namespace text 
 {
@@ -12,9 +15,16 @@ public:
   Word();
   
   explicit Word(std::string const& word);
+  Word(Word const& other);
+  Word(Word&& other) noexcept;
+  Word& operator=(Word const& other);
+  Word& operator=(Word&& other) noexcept;
+  ~Word();
   
   void print(std::ostream& out) const;
   void read(std::istream& in);
+
+  std::string_view spelling() const;
   
   bool operator==(Word const& other) const;
   bool operator!=(Word const& other) const;
@@ -24,10 +34,22 @@ public:
   bool operator>=(Word const& other) const;
   
 private:
-  std::string value;
-  
-  static char toLower(char c);
-  static int compareCaseInsensitive(std::string const& lhs, std::string const& rhs);
+  // Words up to this many letters live inside the object, which keeps it at 32 bytes.
+  static constexpr std::size_t inlineCapacity = 20;
+
+  void assign(std::string_view word);
+  void release();
+  char const* data() const;
+  bool isInline() const;
+
+  static int compareCaseInsensitive(Word const& lhs, Word const& rhs);
+
+  // The first eight letters case-folded, big-endian and zero-padded: comparing
+  // two prefixes orders like comparing those letters, shorter words first.
+  std::uint64_t prefix{};
+  std::uint32_t length{};
+  // The letters, or for longer words a pointer to them on the heap.
+  char storage[inlineCapacity]{};
 };
 
 std::ostream& operator<<(std::ostream& out, Word const& word);
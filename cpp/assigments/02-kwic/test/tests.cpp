@@ -1,11 +1,41 @@
-#include "kwic.hpp"
-#include "word.hpp"
+#include "CaselessCompare.hpp"
+#include "IndexFile.hpp"
+#include "Kwic.hpp"
+#include "KwicIndex.hpp"
+#include "KwicStages.hpp"
+#include "MultikeySort.hpp"
+#include "RotationWriter.hpp"
+#include "Rotations.hpp"
+#include "SuffixArray.hpp"
+#include "StopWords.hpp"
+#include "SuffixIndex.hpp"
+#include "Tokenizer.hpp"
+#include "Vocabulary.hpp"
+#include "Word.hpp"
 
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+#include <span>
 #include <sstream>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+using text::Word;
 
 // ==================== Word Tests ====================
 
@@ -220,6 +250,75 @@ TEST_CASE("test_exercise_example")
 
 // ==================== KWIC Tests ====================
 
+namespace
+{
+  std::vector<std::string> streamedWords(std::string const &text)
+  {
+    std::vector<std::string> words;
+    std::istringstream in{text};
+    Word w;
+    while (in >> w)
+    {
+      words.emplace_back(w.spelling());
+    }
+    return words;
+  }
+
+  std::vector<std::string> scannedWords(std::string const &text)
+  {
+    std::vector<std::string> words;
+    text::WordScanner scanner{text};
+    for (auto word = scanner.next(); !word.empty(); word = scanner.next())
+    {
+      words.emplace_back(word);
+    }
+    return words;
+  }
+}
+
+TEST_CASE("word_scanner_matches_word_read_on_fuzzed_bytes")
+{
+  std::mt19937 random{42};
+  std::string const common{"aZ zA09 ,.-\t\n"};
+  for (int round = 0; round < 2000; ++round)
+  {
+    // Lengths around the 16-byte blocks; bytes mostly letters and blanks, some arbitrary.
+    std::string text(random() % 80, '\0');
+    for (auto &c : text)
+    {
+      c = random() % 4 == 0 ? static_cast<char>(random() % 256) : common[random() % common.size()];
+    }
+    REQUIRE(scannedWords(text) == streamedWords(text));
+  }
+  REQUIRE(scannedWords("").empty());
+  REQUIRE(scannedWords("  123 ").empty());
+  REQUIRE(scannedWords("abcdefghijklmnopqrstuvwxyzABCDEFGHIJ/KLM") == std::vector<std::string>{"abcdefghijklmnopqrstuvwxyzABCDEFGHIJ", "KLM"});
+}
+
+TEST_CASE("line_reader_matches_getline_with_small_blocks")
+{
+  for (std::string const text : {"", "\n", "one", "one\n", "one\ntwo", "\n\none\n\n", "a much longer line than the block\nx\n"})
+  {
+    std::vector<std::string> expected;
+    std::istringstream lines{text};
+    for (std::string line; std::getline(lines, line);)
+    {
+      expected.push_back(line);
+    }
+    for (std::size_t const blockSize : {1, 2, 3, 64})
+    {
+      std::istringstream in{text};
+      text::LineReader reader{in, blockSize};
+      std::vector<std::string> read;
+      for (std::string_view line; reader.next(line);)
+      {
+        read.emplace_back(line);
+      }
+      REQUIRE(read == expected);
+    }
+  }
+}
+
 TEST_CASE("kwic_basic_example")
 {
   std::istringstream input{"this is a test\nthis is another test"};
@@ -228,14 +327,14 @@ TEST_CASE("kwic_basic_example")
   text::kwic(input, output);
 
   std::string expected =
-      "a test this is\n"
-      "another test this is\n"
-      "is a test this\n"
-      "is another test this\n"
-      "test this is a\n"
-      "test this is another\n"
-      "this is a test\n"
-      "this is another test\n";
+      "a test this is \n"
+      "another test this is \n"
+      "is a test this \n"
+      "is another test this \n"
+      "test this is a \n"
+      "test this is another \n"
+      "this is a test \n"
+      "this is another test \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -248,16 +347,16 @@ TEST_CASE("kwic_clarifying_example")
   text::kwic(input, output);
 
   std::string expected =
-      "a a b\n"
-      "a b a\n"
-      "a b c d\n"
-      "b a a\n"
-      "b b c\n"
-      "b c b\n"
-      "b c d a\n"
-      "c b b\n"
-      "c d a b\n"
-      "d a b c\n";
+      "a a b \n"
+      "a b a \n"
+      "a b c d \n"
+      "b a a \n"
+      "b b c \n"
+      "b c b \n"
+      "b c d a \n"
+      "c b b \n"
+      "c d a b \n"
+      "d a b c \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -270,8 +369,8 @@ TEST_CASE("kwic_single_line")
   text::kwic(input, output);
 
   std::string expected =
-      "hello world\n"
-      "world hello\n";
+      "hello world \n"
+      "world hello \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -283,7 +382,7 @@ TEST_CASE("kwic_single_word")
 
   text::kwic(input, output);
 
-  std::string expected = "lonely\n";
+  std::string expected = "lonely \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -306,8 +405,8 @@ TEST_CASE("kwic_case_insensitive_sorting")
   text::kwic(input, output);
 
   std::string expected =
-      "Apple banana\n"
-      "banana Apple\n";
+      "Apple banana \n"
+      "banana Apple \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -320,8 +419,8 @@ TEST_CASE("kwic_ignores_punctuation")
   text::kwic(input, output);
 
   std::string expected =
-      "hello world\n"
-      "world hello\n";
+      "hello world \n"
+      "world hello \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -334,8 +433,8 @@ TEST_CASE("kwic_duplicate_lines")
   text::kwic(input, output);
 
   std::string expected =
-      "line same\n"
-      "same line\n";
+      "line same \n"
+      "same line \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -348,10 +447,10 @@ TEST_CASE("kwic_empty_lines_ignored")
   text::kwic(input, output);
 
   std::string expected =
-      "first line\n"
-      "line first\n"
-      "line second\n"
-      "second line\n";
+      "first line \n"
+      "line first \n"
+      "line second \n"
+      "second line \n";
 
   REQUIRE(output.str() == expected);
 }
@@ -364,9 +463,939 @@ TEST_CASE("kwic_multiple_spaces")
   text::kwic(input, output);
 
   std::string expected =
-      "one two three\n"
-      "three one two\n"
-      "two three one\n";
+      "one two three \n"
+      "three one two \n"
+      "two three one \n";
 
   REQUIRE(output.str() == expected);
 }
+
+TEST_CASE("kwic_repeated_rotations_of_one_line")
+{
+  std::istringstream input{"a b a b"};
+  std::ostringstream output;
+
+  text::kwic(input, output);
+
+  std::string expected =
+      "a b a b \n"
+      "b a b a \n";
+
+  REQUIRE(output.str() == expected);
+}
+
+TEST_CASE("rotation_store_orders_like_materialized_rotations")
+{
+  std::vector<std::string> const vocabulary{"a", "B", "ab", "b", "A", "ba"};
+  text::RotationStore store;
+  std::vector<text::Rotation> rotations;
+  std::vector<text::Line> materialized;
+  for (std::size_t n = 1; n <= 5; ++n)
+  {
+    for (std::size_t seed = 0; seed < 6; ++seed)
+    {
+      text::Line words;
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        words.push_back(Word{vocabulary[(seed * 7 + i * i * 3 + i) % vocabulary.size()]});
+      }
+      auto const id = store.addLine(words);
+      for (std::uint32_t offset = 0; offset < n; ++offset)
+      {
+        rotations.push_back(text::Rotation{id, offset});
+        text::Line rotated = words;
+        std::rotate(rotated.begin(), rotated.begin() + offset, rotated.end());
+        materialized.push_back(rotated);
+      }
+    }
+  }
+
+  store.rank();
+  for (std::size_t i = 0; i < rotations.size(); ++i)
+  {
+    for (std::size_t j = 0; j < rotations.size(); ++j)
+    {
+      REQUIRE(store.less(rotations[i], rotations[j]) == (materialized[i] < materialized[j]));
+    }
+  }
+}
+
+TEST_CASE("rotation_writer_matches_print_for_any_buffer_size")
+{
+  text::RotationStore store;
+  std::vector<text::Rotation> rotations;
+  for (std::string const line : {"Alpha b", "x", "averyveryverylongword and more", "b b b"})
+  {
+    text::WordIds words;
+    std::istringstream lineWords{line};
+    Word w;
+    while (lineWords >> w)
+    {
+      words.push_back(store.vocabulary().intern(w.spelling()));
+    }
+    auto const size = static_cast<std::uint32_t>(words.size());
+    auto const added = store.addLine(std::move(words));
+    for (std::uint32_t offset = 0; offset < size; ++offset)
+    {
+      rotations.push_back(text::Rotation{added, offset});
+    }
+  }
+
+  std::ostringstream expected;
+  for (auto const rotation : rotations)
+  {
+    store.print(rotation, expected);
+    expected << '\n';
+  }
+  for (std::size_t const bufferSize : {1, 2, 5, 16, 4096})
+  {
+    std::ostringstream output;
+    {
+      text::RotationWriter writer{output, bufferSize};
+      for (auto const rotation : rotations)
+      {
+        writer.write(store, rotation);
+      }
+    }
+    REQUIRE(output.str() == expected.str());
+  }
+}
+
+TEST_CASE("vocabulary_interns_each_spelling_once")
+{
+  text::Vocabulary vocabulary;
+  auto const apple = vocabulary.intern("Apple");
+  auto const banana = vocabulary.intern("banana");
+  REQUIRE(vocabulary.intern("Apple") == apple);
+  auto const lowerApple = vocabulary.intern("apple");
+  REQUIRE(lowerApple != apple);
+  REQUIRE(vocabulary.size() == 3);
+  REQUIRE(vocabulary.spelling(apple) == "Apple");
+  REQUIRE(vocabulary.key(apple) == "apple");
+
+  vocabulary.rank();
+  REQUIRE(vocabulary.rankOf(apple) == vocabulary.rankOf(lowerApple));
+  REQUIRE(vocabulary.rankOf(apple) < vocabulary.rankOf(banana));
+}
+
+TEST_CASE("vocabulary_ranks_order_like_words")
+{
+  std::vector<std::string> const spellings{"ADA", "java", "Erlang", "Fortran", "Lisp", "brainfuck", "groovy", "Groovy", "a", "ab", "B"};
+  text::Vocabulary vocabulary;
+  for (auto const &spelling : spellings)
+  {
+    vocabulary.intern(spelling);
+  }
+  vocabulary.rank();
+  for (std::size_t i = 0; i < spellings.size(); ++i)
+  {
+    for (std::size_t j = 0; j < spellings.size(); ++j)
+    {
+      auto const lhs = static_cast<text::WordId>(i);
+      auto const rhs = static_cast<text::WordId>(j);
+      REQUIRE((vocabulary.rankOf(lhs) < vocabulary.rankOf(rhs)) == (Word{spellings[i]} < Word{spellings[j]}));
+    }
+  }
+}
+
+namespace
+{
+  // The original kwic(): a std::set of materialized rotations.
+  std::string referenceKwic(std::string const &text)
+  {
+    std::set<text::Line> allRotations;
+    std::istringstream in{text};
+    std::string inputLine;
+    while (std::getline(in, inputLine))
+    {
+      text::Line words;
+      std::istringstream lineStream(inputLine);
+      Word w;
+      while (lineStream >> w)
+      {
+        words.push_back(w);
+      }
+      for (std::size_t i = 0; i < words.size(); ++i)
+      {
+        text::Line rotation = words;
+        std::rotate(rotation.begin(), rotation.begin() + static_cast<std::ptrdiff_t>(i), rotation.end());
+        allRotations.insert(rotation);
+      }
+    }
+    std::ostringstream out;
+    for (auto const &line : allRotations)
+    {
+      for (auto const &w : line)
+      {
+        out << w << ' ';
+      }
+      out << '\n';
+    }
+    return out.str();
+  }
+
+  // Short lines over a small mixed-case vocabulary with punctuation, so that
+  // rotations collide and compare equal across different spellings.
+  std::string generatedText(std::size_t lines, unsigned seed)
+  {
+    std::vector<std::string> const vocabulary{"a", "A", "an", "And", "the", "The", "THE", "of", "cat", "Cat", "cats", "dog", "do", "x"};
+    std::vector<std::string> const separators{" ", "  ", ", ", " - ", "3", "\t"};
+    std::mt19937 random{seed};
+    std::string text;
+    for (std::size_t l = 0; l < lines; ++l)
+    {
+      std::size_t const length = random() % 6;
+      for (std::size_t w = 0; w < length; ++w)
+      {
+        text += vocabulary[random() % vocabulary.size()];
+        text += separators[random() % separators.size()];
+      }
+      text += '\n';
+    }
+    return text;
+  }
+}
+
+TEST_CASE("kwic_matches_reference_on_generated_text")
+{
+  for (unsigned seed = 1; seed <= 20; ++seed)
+  {
+    auto const text = generatedText(200, seed);
+    std::istringstream input{text};
+    std::ostringstream output;
+    text::kwic(input, output);
+    REQUIRE(output.str() == referenceKwic(text));
+  }
+}
+
+TEST_CASE("parallel_kwic_matches_sequential_kwic")
+{
+  for (unsigned seed = 1; seed <= 10; ++seed)
+  {
+    auto const text = generatedText(300, seed);
+    auto const expected = referenceKwic(text);
+    for (unsigned workers = 1; workers <= 5; ++workers)
+    {
+      std::istringstream input{text};
+      std::ostringstream output;
+      text::kwic(input, output, text::KwicOptions{workers});
+      REQUIRE(output.str() == expected);
+    }
+  }
+}
+
+TEST_CASE("external_kwic_matches_in_memory_kwic")
+{
+  auto const directory = std::filesystem::temp_directory_path() / "kwic-external-test";
+  std::filesystem::create_directories(directory);
+  // A few KiB force many runs and, below twice the run buffer, merge passes.
+  for (std::size_t const budget : {std::size_t{8 * 1024}, std::size_t{96 * 1024}, std::size_t{1} << 30})
+  {
+    for (unsigned seed = 1; seed <= 5; ++seed)
+    {
+      auto const text = generatedText(2000, seed);
+      std::istringstream input{text};
+      std::ostringstream output;
+      text::KwicOptions options{};
+      options.memoryBudget = budget;
+      options.spillDirectory = directory;
+      text::kwic(input, output, options);
+      REQUIRE(output.str() == referenceKwic(text));
+    }
+  }
+  REQUIRE(std::filesystem::is_empty(directory));
+  std::filesystem::remove(directory);
+}
+
+TEST_CASE("external_kwic_merges_many_runs_within_the_descriptor_limit")
+{
+  auto const directory = std::filesystem::temp_directory_path() / "kwic-many-runs-test";
+  std::filesystem::create_directories(directory);
+  text::KwicOptions options{};
+  options.spillDirectory = directory;
+
+  options.memoryBudget = 4000;
+  std::istringstream small{"the cat\n"};
+  std::ostringstream ignored;
+  REQUIRE_THROWS_AS(text::kwic(small, ignored, options), std::invalid_argument);
+
+  // At the smallest budget every line becomes a run of its own; far more runs
+  // than descriptors must still be merged in bounded passes.
+  rlimit const original = [] { rlimit limit{}; getrlimit(RLIMIT_NOFILE, &limit); return limit; }();
+  rlimit lowered = original;
+  lowered.rlim_cur = std::min<rlim_t>(original.rlim_cur, 128);
+  setrlimit(RLIMIT_NOFILE, &lowered);
+
+  auto const text = generatedText(3000, 11);
+  std::istringstream input{text};
+  std::ostringstream output;
+  options.memoryBudget = 8 * 1024;
+  text::kwic(input, output, options);
+  setrlimit(RLIMIT_NOFILE, &original);
+
+  REQUIRE(output.str() == referenceKwic(text));
+  REQUIRE(std::filesystem::is_empty(directory));
+  std::filesystem::remove(directory);
+}
+
+TEST_CASE("parallel_kwic_keeps_input_order_across_small_blocks")
+{
+  // Blocks of a few lines land on different workers, so equal rotations with
+  // different spellings meet in the merge and the earliest must win.
+  for (unsigned seed = 1; seed <= 3; ++seed)
+  {
+    auto const text = generatedText(500, seed);
+    auto const expected = referenceKwic(text);
+    for (std::size_t const blockSize : {std::size_t{1}, std::size_t{64}, std::size_t{1000}})
+    {
+      for (unsigned workers : {2u, 3u})
+      {
+        std::istringstream input{text};
+        std::ostringstream output;
+        text::parallelKwic(input, output, workers, text::StopWords{}, blockSize);
+        REQUIRE(output.str() == expected);
+      }
+    }
+  }
+}
+
+namespace
+{
+  // Serves `text` and then fails, like a device error part-way through.
+  struct FailingBuffer : std::streambuf
+  {
+    explicit FailingBuffer(std::string text)
+        : text{std::move(text)}
+    {
+      setg(this->text.data(), this->text.data(), this->text.data() + this->text.size());
+    }
+
+    int_type underflow() override
+    {
+      throw std::runtime_error{"read failed"};
+    }
+
+    std::string text;
+  };
+}
+
+TEST_CASE("parallel_kwic_rethrows_read_failures_on_the_caller")
+{
+  FailingBuffer buffer{generatedText(2000, 1)};
+  std::istream input{&buffer};
+  std::ostringstream output;
+  REQUIRE_THROWS_AS(text::parallelKwic(input, output, 3, text::StopWords{}, 256), std::runtime_error);
+}
+
+TEST_CASE("parallel_kwic_handles_fewer_lines_than_workers")
+{
+  for (std::string const text : {"", "\n\n", "one line", "The cat\nthe CAT\n"})
+  {
+    std::istringstream input{text};
+    std::ostringstream output;
+    text::kwic(input, output, text::KwicOptions{4});
+    REQUIRE(output.str() == referenceKwic(text));
+  }
+}
+
+namespace
+{
+  std::string contexts(text::KwicIndex const &index, text::KwicIndex::Range range)
+  {
+    std::string result;
+    for (auto const rotation : range)
+    {
+      result += index.context(rotation) + '\n';
+    }
+    return result;
+  }
+
+  // The lines of kwic() output whose first word starts with prefix, ignoring case.
+  std::string withPrefix(std::string const &output, std::string const &prefix, bool whole)
+  {
+    std::istringstream lines{output};
+    std::string result;
+    std::string line;
+    while (std::getline(lines, line))
+    {
+      auto const first = line.substr(0, line.find(' '));
+      auto const matches = whole ? first.size() == prefix.size() : first.size() >= prefix.size();
+      if (matches && Word{first.substr(0, prefix.size())} == Word{prefix})
+      {
+        result += line + '\n';
+      }
+    }
+    return result;
+  }
+}
+
+TEST_CASE("kwic_index_added_line_by_line_matches_kwic")
+{
+  for (unsigned seed = 1; seed <= 5; ++seed)
+  {
+    auto const text = generatedText(3000, seed);
+    text::KwicIndex index;
+    std::istringstream lines{text};
+    std::string line;
+    std::string added;
+    std::size_t count = 0;
+    for (std::size_t number = 1; std::getline(lines, line); ++number)
+    {
+      count += index.addLine(line);
+      added += line + '\n';
+      if (number % 500 == 0)
+      {
+        REQUIRE(contexts(index, index.all()) == referenceKwic(added));
+      }
+    }
+    REQUIRE(index.size() == count);
+    REQUIRE(contexts(index, index.all()) == referenceKwic(text));
+  }
+}
+
+TEST_CASE("kwic_index_mixes_batches_and_single_lines")
+{
+  auto const first = generatedText(500, 1);
+  auto const second = generatedText(500, 2);
+  auto const third = generatedText(500, 3);
+  text::KwicIndex index;
+  std::istringstream batch{first};
+  index.add(batch);
+  std::istringstream lines{second};
+  std::string line;
+  while (std::getline(lines, line))
+  {
+    index.addLine(line);
+  }
+  std::istringstream another{third};
+  index.add(another);
+  REQUIRE(contexts(index, index.all()) == referenceKwic(first + second + third));
+}
+
+TEST_CASE("kwic_index_finds_contexts_by_keyword_and_prefix")
+{
+  auto const text = generatedText(2000, 7);
+  auto const expected = referenceKwic(text);
+  text::KwicIndex index;
+  std::istringstream lines{text};
+  std::string line;
+  while (std::getline(lines, line))
+  {
+    index.addLine(line);
+  }
+  for (std::string const query : {"a", "A", "an", "the", "Ca", "cat", "CATS", "d", "do", "x", "zebra"})
+  {
+    auto const keyword = index.withKeyword(query);
+    REQUIRE(contexts(index, keyword) == withPrefix(expected, query, true));
+    REQUIRE(keyword.size() == static_cast<std::size_t>(std::ranges::distance(keyword)));
+
+    auto const prefix = index.withPrefix(query);
+    REQUIRE(contexts(index, prefix) == withPrefix(expected, query, false));
+    REQUIRE(prefix.size() == static_cast<std::size_t>(std::ranges::distance(prefix)));
+  }
+  REQUIRE(index.withPrefix("").size() == index.size());
+  REQUIRE(index.withKeyword("zebra").empty());
+}
+
+namespace
+{
+  std::string printed(text::IndexFile const &file, std::span<text::Rotation const> rotations)
+  {
+    std::ostringstream output;
+    file.print(rotations, output);
+    return output.str();
+  }
+}
+
+TEST_CASE("index_file_round_trips_kwic_output_and_lookups")
+{
+  auto const path = std::filesystem::temp_directory_path() / "kwic-index-test.idx";
+  for (unsigned seed = 1; seed <= 3; ++seed)
+  {
+    auto const text = generatedText(2000, seed);
+    auto const expected = referenceKwic(text);
+    {
+      text::KwicIndex index;
+      std::istringstream input{text};
+      index.add(input);
+      text::IndexFile::write(index, path);
+    }
+
+    text::IndexFile const file{path};
+    REQUIRE(file.verify());
+    REQUIRE(printed(file, file.rotations()) == expected);
+    for (std::string const query : {"a", "An", "the", "Ca", "CATS", "x", "zebra"})
+    {
+      REQUIRE(printed(file, file.withKeyword(query)) == withPrefix(expected, query, true));
+      REQUIRE(printed(file, file.withPrefix(query)) == withPrefix(expected, query, false));
+    }
+    REQUIRE(file.withPrefix("").size() == file.rotations().size());
+  }
+
+  text::KwicIndex empty;
+  text::IndexFile::write(empty, path);
+  text::IndexFile const file{path};
+  REQUIRE(file.verify());
+  REQUIRE(file.rotations().empty());
+  REQUIRE(printed(file, file.withKeyword("cat")).empty());
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("index_file_rejects_damaged_files")
+{
+  auto const path = std::filesystem::temp_directory_path() / "kwic-damaged-test.idx";
+  {
+    text::KwicIndex index;
+    std::istringstream input{generatedText(200, 1)};
+    index.add(input);
+    text::IndexFile::write(index, path);
+  }
+  auto const size = std::filesystem::file_size(path);
+  auto const overwrite = [&](std::streamoff position, char byte)
+  {
+    std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+    char original{};
+    file.seekg(position);
+    file.get(original);
+    file.seekp(position);
+    file.put(byte);
+    return original;
+  };
+
+  // A flipped byte in the body passes the cheap checks on opening but not verify().
+  auto const middle = static_cast<std::streamoff>(size / 2);
+  auto const original = overwrite(middle, 0);
+  overwrite(middle, static_cast<char>(original ^ 1));
+  REQUIRE_FALSE(text::IndexFile{path}.verify());
+  overwrite(middle, original);
+  REQUIRE(text::IndexFile{path}.verify());
+
+  // The version follows the 8-byte magic number.
+  overwrite(8, 99);
+  REQUIRE_THROWS_AS(text::IndexFile{path}, std::runtime_error);
+  overwrite(8, static_cast<char>(text::IndexFile::version));
+  overwrite(0, 'X');
+  REQUIRE_THROWS_AS(text::IndexFile{path}, std::runtime_error);
+  overwrite(0, 'K');
+
+  std::filesystem::resize_file(path, size - 8);
+  REQUIRE_THROWS_AS(text::IndexFile{path}, std::runtime_error);
+  std::filesystem::remove(path);
+  REQUIRE_THROWS_AS(text::IndexFile{path}, std::system_error);
+}
+
+static_assert(text::isEnglishStopWord("the") && text::isEnglishStopWord("ThE") && text::isEnglishStopWord("with"));
+static_assert(!text::isEnglishStopWord("") && !text::isEnglishStopWord("cat") && !text::isEnglishStopWord("theirs"));
+
+TEST_CASE("english_stop_words_match_a_linear_search")
+{
+  auto const linear = [](std::string const &word)
+  {
+    return std::ranges::any_of(text::stopwords::english, [&](std::string_view stopWord)
+                               { return ascii::compareCaseless(stopWord, word) == 0; });
+  };
+  for (auto const stopWord : text::stopwords::english)
+  {
+    std::string upper{stopWord};
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](char c)
+                   { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+    REQUIRE(text::isEnglishStopWord(upper));
+  }
+  // Every string of up to three letters from a small alphabet.
+  std::string const letters = "aehinorstTw";
+  std::vector<std::string> words{""};
+  for (std::size_t begin = 0, length = 1; length <= 3; ++length)
+  {
+    std::size_t const end = words.size();
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      for (char const letter : letters)
+      {
+        words.push_back(words[i] + letter);
+      }
+    }
+    begin = end;
+  }
+  for (auto const &word : words)
+  {
+    REQUIRE(text::isEnglishStopWord(word) == linear(word));
+  }
+}
+
+TEST_CASE("stop_words_loaded_at_runtime_ignore_case")
+{
+  std::istringstream input{"Lorem, ipsum\n\ndolor3sit IPSUM\n"};
+  auto stopWords = text::StopWords::load(input);
+  for (std::string const word : {"lorem", "LOREM", "Ipsum", "dolor", "sit"})
+  {
+    REQUIRE(stopWords.contains(word));
+  }
+  for (std::string const word : {"", "lore", "ipsums", "the", "sit3"})
+  {
+    REQUIRE_FALSE(stopWords.contains(word));
+  }
+  REQUIRE(text::StopWords{}.empty());
+  REQUIRE_FALSE(stopWords.empty());
+
+  // Enough words to grow the table several times.
+  for (int i = 0; i < 1000; ++i)
+  {
+    stopWords.add("word" + std::string(static_cast<std::size_t>(i % 26 + 1), static_cast<char>('a' + i % 26)) + std::to_string(i));
+  }
+  for (int i = 0; i < 1000; ++i)
+  {
+    REQUIRE(stopWords.contains("WORD" + std::string(static_cast<std::size_t>(i % 26 + 1), static_cast<char>('A' + i % 26)) + std::to_string(i)));
+  }
+  REQUIRE(stopWords.contains("lorem"));
+  REQUIRE_FALSE(stopWords.contains("the"));
+  stopWords.add(text::StopWords::english());
+  REQUIRE(stopWords.contains("the"));
+}
+
+namespace
+{
+  // kwic() output without the lines whose first word is a stop word.
+  std::string withoutStopWords(std::string const &output, text::StopWords const &stopWords)
+  {
+    std::istringstream lines{output};
+    std::string result;
+    std::string line;
+    while (std::getline(lines, line))
+    {
+      if (!stopWords.contains(line.substr(0, line.find(' '))))
+      {
+        result += line + '\n';
+      }
+    }
+    return result;
+  }
+}
+
+TEST_CASE("kwic_never_starts_rotations_with_stop_words")
+{
+  auto const directory = std::filesystem::temp_directory_path() / "kwic-stop-words-test";
+  std::filesystem::create_directories(directory);
+  std::istringstream list{"cat X"};
+  auto const custom = text::StopWords::load(list);
+  auto both = text::StopWords::english();
+  both.add(custom);
+  for (auto const &stopWords : {text::StopWords::english(), custom, both})
+  {
+    for (unsigned seed = 1; seed <= 3; ++seed)
+    {
+      auto const text = generatedText(1000, seed);
+      auto const expected = withoutStopWords(referenceKwic(text), stopWords);
+      for (unsigned workers : {1u, 3u})
+      {
+        for (std::size_t budget : {std::size_t{}, std::size_t{8 * 1024}})
+        {
+          std::istringstream input{text};
+          std::ostringstream output;
+          text::KwicOptions options{workers, budget, directory};
+          options.stopWords = stopWords;
+          text::kwic(input, output, options);
+          REQUIRE(output.str() == expected);
+        }
+      }
+
+      text::KwicIndex index{stopWords};
+      std::istringstream lines{text};
+      std::string line;
+      while (std::getline(lines, line))
+      {
+        index.addLine(line);
+      }
+      REQUIRE(contexts(index, index.all()) == expected);
+      REQUIRE(index.withKeyword("the").empty() == stopWords.contains("the"));
+    }
+  }
+  REQUIRE(std::filesystem::is_empty(directory));
+  std::filesystem::remove(directory);
+}
+
+TEST_CASE("multikey_sort_matches_comparison_sort")
+{
+  for (unsigned seed = 1; seed <= 20; ++seed)
+  {
+    // Repeated lines add long shared prefixes and many equal rotations.
+    auto const text = generatedText(400, seed) + generatedText(100, seed);
+    text::RotationStore store;
+    std::vector<text::Rotation> rotations;
+    std::istringstream lines{text};
+    for (std::string line; std::getline(lines, line);)
+    {
+      text::addLine(line, store, rotations);
+    }
+    store.rank();
+
+    // The comparison sort sortRotations() used before.
+    auto expected = rotations;
+    std::stable_sort(expected.begin(), expected.end(), [&store](text::Rotation lhs, text::Rotation rhs)
+                     { return store.less(lhs, rhs); });
+    expected.erase(std::unique(expected.begin(), expected.end(), [&store](text::Rotation lhs, text::Rotation rhs)
+                               { return !store.less(lhs, rhs); }),
+                   expected.end());
+    text::multikeySortRotations(store, rotations);
+    REQUIRE(rotations.size() == expected.size());
+    for (std::size_t i = 0; i < rotations.size(); ++i)
+    {
+      REQUIRE(rotations[i].line == expected[i].line);
+      REQUIRE(rotations[i].offset == expected[i].offset);
+    }
+  }
+}
+
+TEST_CASE("suffix_array_and_lcp_match_naive_construction")
+{
+  std::mt19937 random{17};
+  for (std::size_t size = 1; size <= 300; size += 7)
+  {
+    for (std::uint32_t const alphabet : {2u, 3u, 10u})
+    {
+      // Small alphabets give long repeats and deep recursion.
+      std::vector<std::uint32_t> symbols(size);
+      for (auto &symbol : symbols)
+      {
+        symbol = 1 + static_cast<std::uint32_t>(random() % (alphabet - 1));
+      }
+      symbols.back() = 0;
+
+      std::vector<std::uint32_t> expected(size);
+      std::iota(expected.begin(), expected.end(), 0u);
+      std::sort(expected.begin(), expected.end(), [&](std::uint32_t lhs, std::uint32_t rhs)
+                { return std::lexicographical_compare(symbols.begin() + lhs, symbols.end(), symbols.begin() + rhs, symbols.end()); });
+      auto const suffixes = text::suffixArray(symbols, alphabet);
+      REQUIRE(suffixes == expected);
+
+      auto const lcp = text::lcpArray(symbols, suffixes);
+      REQUIRE(lcp[0] == 0);
+      for (std::size_t i = 1; i < size; ++i)
+      {
+        auto const mismatch = std::mismatch(symbols.begin() + suffixes[i - 1], symbols.end(), symbols.begin() + suffixes[i], symbols.end());
+        REQUIRE(lcp[i] == static_cast<std::uint32_t>(mismatch.first - (symbols.begin() + suffixes[i - 1])));
+      }
+    }
+  }
+}
+
+TEST_CASE("suffix_index_prints_kwic_order")
+{
+  for (unsigned seed = 1; seed <= 20; ++seed)
+  {
+    auto const text = generatedText(300, seed);
+    std::istringstream input{text};
+    text::SuffixIndex const index{input};
+    std::ostringstream output;
+    index.print(output);
+    REQUIRE(output.str() == referenceKwic(text));
+  }
+  std::istringstream empty{""};
+  REQUIRE(text::SuffixIndex{empty}.rotations().empty());
+}
+
+TEST_CASE("suffix_index_finds_keywords_and_phrases")
+{
+  auto const text = generatedText(2000, 11);
+  auto const expected = referenceKwic(text);
+  std::istringstream input{text};
+  text::SuffixIndex const index{input};
+  for (std::string const phrase : {"a", "CAT", "the", "zebra", "the cat", "The A", "a a a", "of x dog", "cat zebra"})
+  {
+    std::string found;
+    for (auto const rotation : index.find(phrase))
+    {
+      std::string context;
+      index.store().append(rotation, context);
+      found += context + '\n';
+    }
+
+    std::string wanted;
+    std::istringstream lines{expected};
+    for (std::string line; std::getline(lines, line);)
+    {
+      std::istringstream lineWords{line};
+      std::istringstream phraseWords{phrase};
+      Word lineWord;
+      Word phraseWord;
+      bool matches = true;
+      while (matches && phraseWords >> phraseWord)
+      {
+        matches = static_cast<bool>(lineWords >> lineWord) && lineWord == phraseWord;
+      }
+      if (matches)
+      {
+        wanted += line + '\n';
+      }
+    }
+    REQUIRE(found == wanted);
+  }
+}
+
+namespace
+{
+  // Word::compareCaseInsensitive before it moved to the shared kernel.
+  int referenceCompareCaseInsensitive(std::string const &lhs, std::string const &rhs)
+  {
+    auto toLower = [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); };
+    auto lhsIt = lhs.begin();
+    auto rhsIt = rhs.begin();
+    while (lhsIt != lhs.end() && rhsIt != rhs.end())
+    {
+      char lhsChar = toLower(*lhsIt);
+      char rhsChar = toLower(*rhsIt);
+      if (lhsChar < rhsChar)
+      {
+        return -1;
+      }
+      if (lhsChar > rhsChar)
+      {
+        return 1;
+      }
+      ++lhsIt;
+      ++rhsIt;
+    }
+    if (lhsIt == lhs.end() && rhsIt == rhs.end())
+    {
+      return 0;
+    }
+    return lhsIt == lhs.end() ? -1 : 1;
+  }
+
+  int sign(int value)
+  {
+    return (value > 0) - (value < 0);
+  }
+}
+
+TEST_CASE("caseless_compare_matches_word_comparison_on_all_short_words")
+{
+  std::string const letters{"aAbByYzZ"};
+  std::vector<std::string> words;
+  for (std::size_t length = 1; length <= 3; ++length)
+  {
+    std::vector<std::size_t> digits(length);
+    while (true)
+    {
+      std::string word;
+      for (auto const digit : digits)
+      {
+        word += letters[digit];
+      }
+      words.push_back(word);
+      std::size_t position = 0;
+      while (position < length && ++digits[position] == letters.size())
+      {
+        digits[position++] = 0;
+      }
+      if (position == length)
+      {
+        break;
+      }
+    }
+  }
+
+  for (auto const &lhs : words)
+  {
+    for (auto const &rhs : words)
+    {
+      REQUIRE(sign(ascii::compareCaseless(lhs, rhs)) == referenceCompareCaseInsensitive(lhs, rhs));
+      REQUIRE((Word{lhs} < Word{rhs}) == (referenceCompareCaseInsensitive(lhs, rhs) < 0));
+    }
+  }
+}
+
+TEST_CASE("word_comparison_matches_reference_across_prefix_and_inline_sizes")
+{
+  // Two letters in either case give long common prefixes around 8 and 20 letters.
+  std::mt19937 random{5};
+  std::string const letters{"aAbB"};
+  std::vector<std::string> words;
+  for (int i = 0; i < 400; ++i)
+  {
+    std::string word(1 + random() % 30, 'a');
+    for (std::size_t c = 0; c < word.size(); ++c)
+    {
+      word[c] = letters[random() % (c < 6 ? 2 : letters.size())];
+    }
+    words.push_back(word);
+  }
+
+  for (auto const &lhs : words)
+  {
+    for (auto const &rhs : words)
+    {
+      int const expected = referenceCompareCaseInsensitive(lhs, rhs);
+      REQUIRE((Word{lhs} < Word{rhs}) == (expected < 0));
+      REQUIRE((Word{lhs} == Word{rhs}) == (expected == 0));
+    }
+  }
+}
+
+TEST_CASE("word_copies_and_moves_inline_and_heap_spellings")
+{
+  for (std::string const spelling : {"a", "eightchr", "twentyLettersExactly", "TwentyOneLettersLongX", "aVeryMuchLongerWordThanAnyInlineStorage"})
+  {
+    Word const original{spelling};
+    Word copy{original};
+    REQUIRE(copy.spelling() == spelling);
+
+    Word moved{std::move(copy)};
+    REQUIRE(moved.spelling() == spelling);
+
+    Word assigned{};
+    assigned = moved;
+    REQUIRE(assigned.spelling() == spelling);
+    assigned = Word{"short"};
+    REQUIRE(assigned.spelling() == "short");
+    assigned = std::move(moved);
+    REQUIRE(assigned.spelling() == spelling);
+    REQUIRE(assigned == original);
+
+    std::istringstream in{"  " + spelling + "!"};
+    Word read{"x"};
+    in >> read;
+    REQUIRE(read.spelling() == spelling);
+  }
+}
+
+TEST_CASE("caseless_compare_kernels_find_every_mismatch_position")
+{
+  std::mt19937 random{99};
+  std::string const letters{"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ@[`{"};
+  for (std::size_t length = 0; length <= 100; ++length)
+  {
+    std::string lhs;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+      lhs += letters[random() % letters.size()];
+    }
+    std::string same = lhs;
+    for (auto &c : same)
+    {
+      c = ascii::foldCase(c) == c && c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+    REQUIRE(ascii::kernels::scalar(lhs.data(), same.data(), length) == length);
+#if CASELESS_COMPARE_X86
+    REQUIRE(ascii::kernels::sse2(lhs.data(), same.data(), length) == length);
+    if (ascii::kernels::avx2Supported())
+    {
+      REQUIRE(ascii::kernels::avx2(lhs.data(), same.data(), length) == length);
+    }
+#endif
+
+    for (std::size_t position = 0; position < length; ++position)
+    {
+      std::string rhs = same;
+      rhs[position] = rhs[position] == '@' ? '[' : '@';
+      REQUIRE(ascii::kernels::scalar(lhs.data(), rhs.data(), length) == position);
+#if CASELESS_COMPARE_X86
+      REQUIRE(ascii::kernels::sse2(lhs.data(), rhs.data(), length) == position);
+      if (ascii::kernels::avx2Supported())
+      {
+        REQUIRE(ascii::kernels::avx2(lhs.data(), rhs.data(), length) == position);
+      }
+#endif
+      REQUIRE(sign(ascii::compareCaseless(lhs, rhs)) == referenceCompareCaseInsensitive(lhs, rhs));
+    }
+  }
+}
@@ -1,11 +1,11 @@
 #ifndef INDEXABLE_SET_HPP
 #define INDEXABLE_SET_HPP
 
+#include "CaselessCompare.hpp"
+
 #include <set>
 #include <stdexcept>
 #include <iterator>
-#include <algorithm>
-#include <cctype>
 #include <string>
 
 template <typename T, typename Compare = std::less<T>>
@@ -48,13 +48,10 @@ public:
 
 struct caselessCompare
 {
+    // Same order as comparing tolower'ed copies, without making them.
     bool operator()(const std::string &a, const std::string &b) const
     {
-        std::string lower_a = a;
-        std::string lower_b = b;
-        std::transform(lower_a.begin(), lower_a.end(), lower_a.begin(), ::tolower);
-        std::transform(lower_b.begin(), lower_b.end(), lower_b.begin(), ::tolower);
-        return lower_a < lower_b;
+        return ascii::compareCaseless(a, b) < 0;
     }
 };
 
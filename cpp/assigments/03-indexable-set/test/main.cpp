@@ -1,7 +1,11 @@
-#include "indexableSet.hpp"
+#include "IndexableSet.hpp"
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <string>
+
 TEST_CASE("IndexableSet basic functionality", "[indexableSet]")
 {
   IndexableSet<int> s;
@@ -85,3 +89,34 @@ TEST_CASE("IndexableSet with custom comparator", "[indexableSet]")
   REQUIRE(s[1] == "banana");
   REQUIRE(s[2] == "Cherry");
 }
+
+TEST_CASE("caselessCompare orders like comparing lowered copies", "[indexableSet]")
+{
+  auto const reference = [](std::string a, std::string b)
+  {
+    std::transform(a.begin(), a.end(), a.begin(), ::tolower);
+    std::transform(b.begin(), b.end(), b.begin(), ::tolower);
+    return a < b;
+  };
+  caselessCompare const compare{};
+
+  for (int x = 0; x < 256; ++x)
+  {
+    for (int y = 0; y < 256; ++y)
+    {
+      std::string const a(1, static_cast<char>(x));
+      std::string const b(1, static_cast<char>(y));
+      REQUIRE(compare(a, b) == reference(a, b));
+      REQUIRE(compare(a + b, b) == reference(a + b, b));
+    }
+  }
+
+  std::string const prefix(40, 'Q');
+  for (int x = 0; x < 256; ++x)
+  {
+    std::string const a = prefix + static_cast<char>(x) + "tail";
+    std::string const b = std::string(40, 'q') + "M" + "tail";
+    REQUIRE(compare(a, b) == reference(a, b));
+    REQUIRE(compare(b, a) == reference(b, a));
+  }
+}
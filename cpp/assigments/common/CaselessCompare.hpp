@@ -0,0 +1,131 @@
+#ifndef CASELESS_COMPARE_HPP
+#define CASELESS_COMPARE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CASELESS_COMPARE_X86 1
+#else
+#define CASELESS_COMPARE_X86 0
+#endif
+
+// ASCII case-insensitive comparison shared by the assignments. Bytes compare as
+// unsigned char after mapping 'A'..'Z' to 'a'..'z', which is what lowering both
+// strings with std::tolower in the "C" locale and comparing them does, without
+// copying either string. Long inputs are scanned 16 (SSE2) or 32 (AVX2) bytes at
+// a time; the kernel is chosen once at runtime.
+namespace ascii
+{
+
+    constexpr char foldCase(char c)
+    {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+    }
+
+    namespace kernels
+    {
+
+        // Each returns the first index below `size` where the folded bytes differ, or `size`.
+        inline std::size_t scalar(char const *lhs, char const *rhs, std::size_t size)
+        {
+            std::size_t i = 0;
+            while (i < size && foldCase(lhs[i]) == foldCase(rhs[i]))
+            {
+                ++i;
+            }
+            return i;
+        }
+
+#if CASELESS_COMPARE_X86
+        [[gnu::target("sse2")]] inline __m128i fold(__m128i bytes)
+        {
+            // 'A'..'Z' move to -128..-103, the only signed bytes below -102.
+            __m128i const shifted = _mm_add_epi8(bytes, _mm_set1_epi8(static_cast<char>(0x80 - 'A')));
+            __m128i const upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(-128 + 26)));
+            return _mm_or_si128(bytes, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        }
+
+        [[gnu::target("sse2")]] inline std::size_t sse2(char const *lhs, char const *rhs, std::size_t size)
+        {
+            std::size_t i = 0;
+            for (; i + 16 <= size; i += 16)
+            {
+                __m128i const left = fold(_mm_loadu_si128(reinterpret_cast<__m128i const *>(lhs + i)));
+                __m128i const right = fold(_mm_loadu_si128(reinterpret_cast<__m128i const *>(rhs + i)));
+                auto const equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(left, right)));
+                if (equal != 0xFFFF)
+                {
+                    return i + static_cast<std::size_t>(__builtin_ctz(~equal));
+                }
+            }
+            return i + scalar(lhs + i, rhs + i, size - i);
+        }
+
+        [[gnu::target("avx2")]] inline __m256i fold(__m256i bytes)
+        {
+            __m256i const shifted = _mm256_add_epi8(bytes, _mm256_set1_epi8(static_cast<char>(0x80 - 'A')));
+            __m256i const upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(-128 + 26)), shifted);
+            return _mm256_or_si256(bytes, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+        }
+
+        [[gnu::target("avx2")]] inline std::size_t avx2(char const *lhs, char const *rhs, std::size_t size)
+        {
+            std::size_t i = 0;
+            for (; i + 32 <= size; i += 32)
+            {
+                __m256i const left = fold(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(lhs + i)));
+                __m256i const right = fold(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(rhs + i)));
+                auto const equal = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(left, right)));
+                if (equal != 0xFFFFFFFFu)
+                {
+                    return i + static_cast<std::size_t>(__builtin_ctz(~equal));
+                }
+            }
+            return i + scalar(lhs + i, rhs + i, size - i);
+        }
+
+        inline bool avx2Supported()
+        {
+            static bool const supported = []
+            {
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") != 0;
+            }();
+            return supported;
+        }
+#endif
+
+    }
+
+    // First index where the folded strings differ, or the length of the shorter one.
+    inline std::size_t mismatchCaseless(std::string_view lhs, std::string_view rhs)
+    {
+        std::size_t const size = std::min(lhs.size(), rhs.size());
+#if CASELESS_COMPARE_X86
+        // Short words, the common case, are not worth a vector setup.
+        if (size >= 16)
+        {
+            return kernels::avx2Supported() ? kernels::avx2(lhs.data(), rhs.data(), size)
+                                            : kernels::sse2(lhs.data(), rhs.data(), size);
+        }
+#endif
+        return kernels::scalar(lhs.data(), rhs.data(), size);
+    }
+
+    // Negative, zero or positive as lhs orders before, equal to or after rhs.
+    inline int compareCaseless(std::string_view lhs, std::string_view rhs)
+    {
+        std::size_t const i = mismatchCaseless(lhs, rhs);
+        if (i < lhs.size() && i < rhs.size())
+        {
+            return static_cast<unsigned char>(foldCase(lhs[i])) < static_cast<unsigned char>(foldCase(rhs[i])) ? -1 : 1;
+        }
+        return lhs.size() < rhs.size() ? -1 : lhs.size() > rhs.size() ? 1 : 0;
+    }
+
+}
+
+#endif
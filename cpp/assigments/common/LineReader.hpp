@@ -0,0 +1,127 @@
+#ifndef LINE_READER_HPP
+#define LINE_READER_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+// Block line reader shared by the assignments. Yields the lines std::getline
+// would, but reads the stream in large blocks straight from its buffer and
+// hands out views instead of copying every line into a std::string.
+namespace io
+{
+
+    class LineReader
+    {
+    public:
+        static constexpr std::size_t defaultBlockSize = 64 * 1024;
+
+        explicit LineReader(std::istream &input, std::size_t blockSize = defaultBlockSize)
+            : input{&input}, buffer(blockSize == 0 ? 1 : blockSize)
+        {
+            cursor = limit = buffer.data();
+        }
+
+        explicit LineReader(std::string_view contents)
+            : cursor{contents.data()}, limit{contents.data() + contents.size()}, exhausted{true}
+        {
+        }
+
+        // Yields the next line without its '\n'. The view stays valid until the next call.
+        bool next(std::string_view &line)
+        {
+            char const *scanned = cursor;
+            while (true)
+            {
+                auto const remaining = static_cast<std::size_t>(limit - scanned);
+                auto const *newline = remaining != 0 ? static_cast<char const *>(std::memchr(scanned, '\n', remaining)) : nullptr;
+                if (newline)
+                {
+                    line = std::string_view{cursor, static_cast<std::size_t>(newline - cursor)};
+                    cursor = newline + 1;
+                    return true;
+                }
+                if (exhausted)
+                {
+                    if (cursor == limit)
+                    {
+                        return false;
+                    }
+                    line = std::string_view{cursor, static_cast<std::size_t>(limit - cursor)};
+                    cursor = limit;
+                    return true;
+                }
+                auto const pending = static_cast<std::size_t>(limit - cursor);
+                if (!refill())
+                {
+                    exhausted = true;
+                    input->setstate(std::ios::eofbit);
+                }
+                scanned = cursor + pending;
+            }
+        }
+
+        // Yields as many whole lines (with their '\n') as fit into maxBytes, but at least one.
+        bool nextLines(std::string_view &lines, std::size_t maxBytes)
+        {
+            while (true)
+            {
+                std::string_view const buffered{cursor, static_cast<std::size_t>(limit - cursor)};
+                auto end = buffered.substr(0, maxBytes).rfind('\n');
+                if (end == std::string_view::npos)
+                {
+                    end = buffered.find('\n', maxBytes);
+                }
+                if (end != std::string_view::npos)
+                {
+                    lines = buffered.substr(0, end + 1);
+                    cursor += lines.size();
+                    return true;
+                }
+                if (exhausted)
+                {
+                    lines = buffered;
+                    cursor = limit;
+                    return !lines.empty();
+                }
+                if (!refill())
+                {
+                    exhausted = true;
+                    input->setstate(std::ios::eofbit);
+                }
+            }
+        }
+
+    private:
+        // Moves the unread rest to the front, growing the buffer for lines longer than it.
+        bool refill()
+        {
+            auto const pending = static_cast<std::size_t>(limit - cursor);
+            if (pending == buffer.size())
+            {
+                buffer.resize(buffer.size() * 2);
+            }
+            else
+            {
+                std::memmove(buffer.data(), cursor, pending);
+            }
+            cursor = buffer.data();
+            limit = cursor + pending;
+
+            auto const got = input->rdbuf()->sgetn(buffer.data() + pending, static_cast<std::streamsize>(buffer.size() - pending));
+            limit += got;
+            return got > 0;
+        }
+
+        std::istream *input{};
+        std::vector<char> buffer;
+        char const *cursor{};
+        char const *limit{};
+        bool exhausted{};
+    };
+
+}
+
+#endif